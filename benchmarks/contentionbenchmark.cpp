@@ -0,0 +1,307 @@
+#include <benchmark/benchmark.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include <sys/resource.h>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "future.hpp"
+#include "histogram.hpp"
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    constexpr std::size_t s_rounds = 64;
+    constexpr std::size_t s_pairsPerThread = 1024;
+
+    template <std::size_t Size>
+    using Payload = std::array<std::byte, Size>;
+
+    void pinCurrentThread(std::size_t index)
+    {
+#ifdef __linux__
+        const auto cpuCount = std::max(1u, std::thread::hardware_concurrency());
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(index % cpuCount, &cpus);
+        pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+#else
+        (void)index;
+#endif
+    }
+
+    /// Pins the current thread for the scope and restores its previous affinity afterwards,
+    /// for the benchmark thread that runs the other benchmarks too.
+    class ScopedPin
+    {
+    public:
+        explicit ScopedPin(std::size_t index) noexcept
+        {
+#ifdef __linux__
+            CPU_ZERO(&m_previous);
+            m_saved = (0 == pthread_getaffinity_np(pthread_self(), sizeof(m_previous), &m_previous));
+#endif
+            pinCurrentThread(index);
+        }
+
+        ~ScopedPin()
+        {
+#ifdef __linux__
+            if (m_saved)
+            {
+                pthread_setaffinity_np(pthread_self(), sizeof(m_previous), &m_previous);
+            }
+#endif
+        }
+
+        ScopedPin(const ScopedPin&) = delete;
+        ScopedPin& operator=(const ScopedPin&) = delete;
+
+    private:
+#ifdef __linux__
+        cpu_set_t m_previous;
+        bool m_saved = false;
+#endif
+    };
+
+    std::int64_t contextSwitches()
+    {
+        rusage usage{};
+        getrusage(RUSAGE_SELF, &usage);
+        return usage.ru_nvcsw + usage.ru_nivcsw;
+    }
+
+    std::uint64_t nanosecondsBetween(Clock::time_point start, Clock::time_point end)
+    {
+        return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+    }
+
+    /// Latencies recorded by the worker threads of all benchmark iterations.
+    class LatencyCollector
+    {
+    public:
+        void merge(const tclib::LatencyHistogram& histogram)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_histogram.merge(histogram);
+        }
+
+        void report(benchmark::State& state) const
+        {
+            state.counters["p50_ns"] = static_cast<double>(m_histogram.valueAtPercentile(50.0));
+            state.counters["p99_ns"] = static_cast<double>(m_histogram.valueAtPercentile(99.0));
+            state.counters["p999_ns"] = static_cast<double>(m_histogram.valueAtPercentile(99.9));
+        }
+
+    private:
+        std::mutex m_mutex;
+        tclib::LatencyHistogram m_histogram;
+    };
+
+    /// Starts the measured part when all the threads are running.
+    class StartGate
+    {
+    public:
+        explicit StartGate(std::size_t threadCount) noexcept
+            : m_waiting{threadCount}
+        {}
+
+        void arriveAndWait() noexcept
+        {
+            m_waiting.fetch_sub(1, std::memory_order_acq_rel);
+            waitUntil(m_waiting, 0);
+        }
+
+        void waitForAll() const noexcept
+        {
+            waitUntil(m_waiting, 0);
+        }
+
+        static void waitUntil(const std::atomic<std::size_t>& value, std::size_t expected) noexcept
+        {
+            while (value.load(std::memory_order_acquire) != expected)
+            {
+                std::this_thread::yield();
+            }
+        }
+
+    private:
+        std::atomic<std::size_t> m_waiting;
+    };
+
+    void reportCommon(benchmark::State& state, std::int64_t switches, std::int64_t items, LatencyCollector& latencies)
+    {
+        state.SetItemsProcessed(items);
+        state.counters["ctx_switches"] = benchmark::Counter(static_cast<double>(switches),
+                                                            benchmark::Counter::kAvgIterations);
+        latencies.report(state);
+    }
+
+    /// range(0) waiter threads block in SharedFuture::wait() on one state per round,
+    /// the next round starts when all waiters woke up. range(1) pins the threads to cpus.
+    template <std::size_t PayloadSize>
+    void BM_ManyWaitersOneState(benchmark::State& state)
+    {
+        const auto waiterCount = static_cast<std::size_t>(state.range(0));
+        const auto pin = (0 != state.range(1));
+        LatencyCollector latencies;
+        const auto switchesBefore = contextSwitches();
+
+        for (auto _ : state)
+        {
+            std::vector<tclib::Promise<Payload<PayloadSize>>> promises(s_rounds);
+            std::vector<tclib::SharedFuture<Payload<PayloadSize>>> futures;
+            futures.reserve(s_rounds);
+            for (auto& promise : promises)
+            {
+                futures.push_back(promise.getFuture().share());
+            }
+            std::vector<Clock::time_point> setTimes(s_rounds);
+            std::atomic<std::size_t> woken{0};
+            StartGate gate{waiterCount};
+
+            std::vector<std::thread> waiters;
+            waiters.reserve(waiterCount);
+            for (std::size_t i = 0; i < waiterCount; ++i)
+            {
+                waiters.emplace_back([&, i]()
+                {
+                    if (pin)
+                    {
+                        pinCurrentThread(i + 1);
+                    }
+                    tclib::LatencyHistogram histogram;
+                    gate.arriveAndWait();
+                    for (std::size_t round = 0; round < s_rounds; ++round)
+                    {
+                        futures[round].wait();
+                        histogram.record(nanosecondsBetween(setTimes[round], Clock::now()));
+                        benchmark::DoNotOptimize(futures[round].get());
+                        woken.fetch_add(1, std::memory_order_acq_rel);
+                    }
+                    latencies.merge(histogram);
+                });
+            }
+            std::optional<ScopedPin> setterPin;
+            if (pin)
+            {
+                setterPin.emplace(0);
+            }
+
+            gate.waitForAll();
+            const auto start = Clock::now();
+            for (std::size_t round = 0; round < s_rounds; ++round)
+            {
+                //the time is published to the waiters by the shared state synchronization
+                setTimes[round] = Clock::now();
+                promises[round].setValue(Payload<PayloadSize>{});
+                StartGate::waitUntil(woken, (round + 1) * waiterCount);
+            }
+            const auto end = Clock::now();
+
+            for (auto& waiter : waiters)
+            {
+                waiter.join();
+            }
+            state.SetIterationTime(std::chrono::duration<double>(end - start).count());
+        }
+
+        reportCommon(state, contextSwitches() - switchesBefore,
+                     state.iterations() * static_cast<std::int64_t>(s_rounds * waiterCount), latencies);
+    }
+
+    /// range(0) producer threads fulfil independent promises while as many consumer threads
+    /// get the futures of the same promises in order. range(1) pins the threads to cpus.
+    template <std::size_t PayloadSize>
+    void BM_ManyIndependentPairs(benchmark::State& state)
+    {
+        const auto threadCount = static_cast<std::size_t>(state.range(0));
+        const auto pin = (0 != state.range(1));
+        const auto pairCount = threadCount * s_pairsPerThread;
+        LatencyCollector latencies;
+        const auto switchesBefore = contextSwitches();
+
+        for (auto _ : state)
+        {
+            std::vector<tclib::Promise<Payload<PayloadSize>>> promises(pairCount);
+            std::vector<tclib::Future<Payload<PayloadSize>>> futures;
+            futures.reserve(pairCount);
+            for (auto& promise : promises)
+            {
+                futures.push_back(promise.getFuture());
+            }
+            std::vector<Clock::time_point> setTimes(pairCount);
+            StartGate gate{2 * threadCount};
+
+            std::vector<std::thread> threads;
+            threads.reserve(2 * threadCount);
+            for (std::size_t i = 0; i < threadCount; ++i)
+            {
+                const auto first = i * s_pairsPerThread;
+                threads.emplace_back([&, i, first]()
+                {
+                    if (pin)
+                    {
+                        pinCurrentThread(2 * i);
+                    }
+                    gate.arriveAndWait();
+                    for (std::size_t j = first; j < first + s_pairsPerThread; ++j)
+                    {
+                        setTimes[j] = Clock::now();
+                        promises[j].setValue(Payload<PayloadSize>{});
+                    }
+                });
+                threads.emplace_back([&, i, first]()
+                {
+                    if (pin)
+                    {
+                        pinCurrentThread(2 * i + 1);
+                    }
+                    tclib::LatencyHistogram histogram;
+                    gate.arriveAndWait();
+                    for (std::size_t j = first; j < first + s_pairsPerThread; ++j)
+                    {
+                        benchmark::DoNotOptimize(futures[j].get());
+                        histogram.record(nanosecondsBetween(setTimes[j], Clock::now()));
+                    }
+                    latencies.merge(histogram);
+                });
+            }
+
+            gate.waitForAll();
+            const auto start = Clock::now();
+            for (auto& thread : threads)
+            {
+                thread.join();
+            }
+            const auto end = Clock::now();
+            state.SetIterationTime(std::chrono::duration<double>(end - start).count());
+        }
+
+        reportCommon(state, contextSwitches() - switchesBefore,
+                     state.iterations() * static_cast<std::int64_t>(pairCount), latencies);
+    }
+
+    void contentionArguments(benchmark::internal::Benchmark* benchmark)
+    {
+        benchmark->ArgNames({"threads", "pinned"})
+                 ->ArgsProduct({{1, 4, 16, 64}, {0, 1}})
+                 ->UseManualTime();
+    }
+
+    BENCHMARK_TEMPLATE(BM_ManyWaitersOneState, 8)->Apply(contentionArguments);
+    BENCHMARK_TEMPLATE(BM_ManyWaitersOneState, 4096)->Apply(contentionArguments);
+    BENCHMARK_TEMPLATE(BM_ManyIndependentPairs, 8)->Apply(contentionArguments);
+    BENCHMARK_TEMPLATE(BM_ManyIndependentPairs, 4096)->Apply(contentionArguments);
+}
@@ -0,0 +1,33 @@
+#include <benchmark/benchmark.h>
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "future.hpp"
+
+namespace
+{
+    /// Measures the construction of a promise, the sizeof counter tracks the memory footprint of the shared state.
+    /// Expected on 64-bit libstdc++ without TCLIB_ENABLE_CACHE_LINE_LAYOUT: 160 bytes for void, std::int32_t
+    /// and std::int64_t, 192 bytes for std::string, as before the side block; the interrupt, cancellation
+    /// and abandonment data is allocated in the side block on first use, the awaiter list shares the storage
+    /// of the result.
+    template <typename T>
+    void BM_SharedStateFootprint(benchmark::State& state)
+    {
+        for (auto _ : state)
+        {
+            tclib::Promise<T> promise;
+            benchmark::DoNotOptimize(promise);
+        }
+        state.counters["sizeof"] = static_cast<double>(sizeof (tclib::SharedState<T>));
+        state.counters["alignof"] = static_cast<double>(alignof(tclib::SharedState<T>));
+    }
+    BENCHMARK_TEMPLATE(BM_SharedStateFootprint, void);
+    BENCHMARK_TEMPLATE(BM_SharedStateFootprint, std::int32_t);
+    BENCHMARK_TEMPLATE(BM_SharedStateFootprint, std::int64_t);
+    BENCHMARK_TEMPLATE(BM_SharedStateFootprint, std::string);
+    BENCHMARK_TEMPLATE(BM_SharedStateFootprint, std::vector<std::int32_t>);
+    BENCHMARK_TEMPLATE(BM_SharedStateFootprint, std::array<char, 256>);
+}
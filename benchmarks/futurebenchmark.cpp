@@ -0,0 +1,207 @@
+#include <benchmark/benchmark.h>
+
+#include <future>
+#include <thread>
+#include <vector>
+#include "future.hpp"
+
+namespace
+{
+    constexpr std::size_t s_crossThreadBatch = 1000;
+
+    void BM_PromiseSetThenGet(benchmark::State& state)
+    {
+        for (auto _ : state)
+        {
+            tclib::Promise<std::int32_t> promise;
+            auto future = promise.getFuture();
+            promise.setValue(42);
+            benchmark::DoNotOptimize(future.get());
+        }
+    }
+    BENCHMARK(BM_PromiseSetThenGet);
+
+    void BM_StdPromiseSetThenGet(benchmark::State& state)
+    {
+        for (auto _ : state)
+        {
+            std::promise<std::int32_t> promise;
+            auto future = promise.get_future();
+            promise.set_value(42);
+            benchmark::DoNotOptimize(future.get());
+        }
+    }
+    BENCHMARK(BM_StdPromiseSetThenGet);
+
+    /// The promises are set by another thread while the current one gets the futures in the same order.
+    template <typename PromiseType, typename FutureType>
+    void crossThreadSetAndGet(benchmark::State& state)
+    {
+        for (auto _ : state)
+        {
+            std::vector<PromiseType> promises(s_crossThreadBatch);
+            std::vector<FutureType> futures;
+            futures.reserve(s_crossThreadBatch);
+            for (auto& promise : promises)
+            {
+                if constexpr (std::is_same<PromiseType, std::promise<std::int32_t>>::value)
+                {
+                    futures.push_back(promise.get_future());
+                }
+                else
+                {
+                    futures.push_back(promise.getFuture());
+                }
+            }
+
+            std::thread producer([&promises]()
+            {
+                for (auto& promise : promises)
+                {
+                    if constexpr (std::is_same<PromiseType, std::promise<std::int32_t>>::value)
+                    {
+                        promise.set_value(42);
+                    }
+                    else
+                    {
+                        promise.setValue(42);
+                    }
+                }
+            });
+            for (auto& future : futures)
+            {
+                benchmark::DoNotOptimize(future.get());
+            }
+            producer.join();
+        }
+        state.SetItemsProcessed(state.iterations() * s_crossThreadBatch);
+    }
+
+    void BM_PromiseSetThenGetCrossThread(benchmark::State& state)
+    {
+        crossThreadSetAndGet<tclib::Promise<std::int32_t>, tclib::Future<std::int32_t>>(state);
+    }
+    BENCHMARK(BM_PromiseSetThenGetCrossThread)->UseRealTime();
+
+    void BM_StdPromiseSetThenGetCrossThread(benchmark::State& state)
+    {
+        crossThreadSetAndGet<std::promise<std::int32_t>, std::future<std::int32_t>>(state);
+    }
+    BENCHMARK(BM_StdPromiseSetThenGetCrossThread)->UseRealTime();
+
+    std::int32_t increment(tclib::Future<std::int32_t> future)
+    {
+        return future.get() + 1;
+    }
+
+    void BM_ThenChain(benchmark::State& state)
+    {
+        const auto depth = state.range(0);
+        for (auto _ : state)
+        {
+            tclib::Promise<std::int32_t> promise;
+            auto future = promise.getFuture();
+            for (std::int64_t i = 0; i < depth; ++i)
+            {
+                future = future.then(increment);
+            }
+            promise.setValue(0);
+            benchmark::DoNotOptimize(future.get());
+        }
+        state.SetItemsProcessed(state.iterations() * depth);
+    }
+    BENCHMARK(BM_ThenChain)->RangeMultiplier(10)->Range(1, 10000);
+
+    std::int32_t incrementValue(std::int32_t value)
+    {
+        return value + 1;
+    }
+
+    void BM_ThenFiveStages(benchmark::State& state)
+    {
+        for (auto _ : state)
+        {
+            tclib::Promise<std::int32_t> promise;
+            auto future = promise.getFuture()
+                    .then(increment).then(increment).then(increment).then(increment).then(increment);
+            promise.setValue(0);
+            benchmark::DoNotOptimize(future.get());
+        }
+    }
+    BENCHMARK(BM_ThenFiveStages);
+
+    void BM_DeferredFiveStages(benchmark::State& state)
+    {
+        for (auto _ : state)
+        {
+            tclib::Promise<std::int32_t> promise;
+            auto future = promise.getFuture()
+                    .defer()
+                    .then(incrementValue).then(incrementValue).then(incrementValue)
+                    .then(incrementValue).then(incrementValue)
+                    .toFuture();
+            promise.setValue(0);
+            benchmark::DoNotOptimize(future.get());
+        }
+    }
+    BENCHMARK(BM_DeferredFiveStages);
+
+    void BM_SharedFutureFanOut(benchmark::State& state)
+    {
+        const auto readers = static_cast<std::size_t>(state.range(0));
+        for (auto _ : state)
+        {
+            tclib::Promise<std::int32_t> promise;
+            auto sharedFuture = promise.getFuture().share();
+            std::vector<tclib::SharedFuture<std::int32_t>> copies(readers, sharedFuture);
+            promise.setValue(42);
+            for (auto& copy : copies)
+            {
+                benchmark::DoNotOptimize(copy.get());
+            }
+        }
+        state.SetItemsProcessed(state.iterations() * readers);
+    }
+    BENCHMARK(BM_SharedFutureFanOut)->RangeMultiplier(4)->Range(1, 256);
+
+    void BM_SharedFutureFanOutThreads(benchmark::State& state)
+    {
+        const auto readers = static_cast<std::size_t>(state.range(0));
+        for (auto _ : state)
+        {
+            tclib::Promise<std::int32_t> promise;
+            auto sharedFuture = promise.getFuture().share();
+            std::vector<std::thread> threads;
+            threads.reserve(readers);
+            for (std::size_t i = 0; i < readers; ++i)
+            {
+                threads.emplace_back([sharedFuture]() mutable { benchmark::DoNotOptimize(sharedFuture.get()); });
+            }
+            promise.setValue(42);
+            for (auto& thread : threads)
+            {
+                thread.join();
+            }
+        }
+        state.SetItemsProcessed(state.iterations() * readers);
+    }
+    BENCHMARK(BM_SharedFutureFanOutThreads)->RangeMultiplier(4)->Range(1, 16)->UseRealTime();
+
+    void BM_StdSharedFutureFanOut(benchmark::State& state)
+    {
+        const auto readers = static_cast<std::size_t>(state.range(0));
+        for (auto _ : state)
+        {
+            std::promise<std::int32_t> promise;
+            auto sharedFuture = promise.get_future().share();
+            std::vector<std::shared_future<std::int32_t>> copies(readers, sharedFuture);
+            promise.set_value(42);
+            for (auto& copy : copies)
+            {
+                benchmark::DoNotOptimize(copy.get());
+            }
+        }
+        state.SetItemsProcessed(state.iterations() * readers);
+    }
+    BENCHMARK(BM_StdSharedFutureFanOut)->RangeMultiplier(4)->Range(1, 256);
+}
@@ -0,0 +1,74 @@
+#include <benchmark/benchmark.h>
+
+#include <array>
+#include <functional>
+#include "uniquefunction.hpp"
+
+namespace
+{
+    struct SmallCallable
+    {
+        std::int64_t operator()(std::int64_t x) const { return x + m_value; }
+
+        std::int64_t m_value = 1;
+    };
+
+    struct BigCallable
+    {
+        std::int64_t operator()(std::int64_t x) const { return x + m_values[0]; }
+
+        std::array<std::int64_t, 16> m_values{{1}};
+    };
+
+    template <typename Function, typename Callable>
+    void construct(benchmark::State& state)
+    {
+        for (auto _ : state)
+        {
+            Function f(Callable{});
+            benchmark::DoNotOptimize(f);
+        }
+    }
+
+    template <typename Function, typename Callable>
+    void move(benchmark::State& state)
+    {
+        Function f(Callable{});
+        for (auto _ : state)
+        {
+            Function g(std::move(f));
+            f = std::move(g);
+            benchmark::DoNotOptimize(f);
+        }
+    }
+
+    template <typename Function, typename Callable>
+    void invoke(benchmark::State& state)
+    {
+        Function f(Callable{});
+        std::int64_t x = 0;
+        for (auto _ : state)
+        {
+            x = f(x);
+            benchmark::DoNotOptimize(x);
+        }
+    }
+
+    using UniqueFunctionType = tclib::UniqueFunction<std::int64_t(std::int64_t)>;
+    using StdFunctionType = std::function<std::int64_t(std::int64_t)>;
+
+    BENCHMARK_TEMPLATE(construct, UniqueFunctionType, SmallCallable);
+    BENCHMARK_TEMPLATE(construct, StdFunctionType, SmallCallable);
+    BENCHMARK_TEMPLATE(construct, UniqueFunctionType, BigCallable);
+    BENCHMARK_TEMPLATE(construct, StdFunctionType, BigCallable);
+
+    BENCHMARK_TEMPLATE(move, UniqueFunctionType, SmallCallable);
+    BENCHMARK_TEMPLATE(move, StdFunctionType, SmallCallable);
+    BENCHMARK_TEMPLATE(move, UniqueFunctionType, BigCallable);
+    BENCHMARK_TEMPLATE(move, StdFunctionType, BigCallable);
+
+    BENCHMARK_TEMPLATE(invoke, UniqueFunctionType, SmallCallable);
+    BENCHMARK_TEMPLATE(invoke, StdFunctionType, SmallCallable);
+    BENCHMARK_TEMPLATE(invoke, UniqueFunctionType, BigCallable);
+    BENCHMARK_TEMPLATE(invoke, StdFunctionType, BigCallable);
+}
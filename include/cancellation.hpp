@@ -0,0 +1,78 @@
+#ifndef CANCELLATION_HPP
+#define CANCELLATION_HPP
+
+#include <atomic>
+#include <memory>
+
+namespace tclib
+{
+
+template <typename Result> class SharedState;
+
+namespace cancellation_details
+{
+    struct CancellationState
+    {
+        std::atomic<bool> m_cancelled{false};
+    };
+}
+
+/// @brief Observer of a cancellation request of CancellationSource.
+/// @details Default constructed token is never cancelled. Checking the token is a single atomic load.
+class CancellationToken
+{
+public:
+    CancellationToken() = default;
+
+    bool isCancellationRequested() const noexcept
+    {
+        return m_statePtr && m_statePtr->m_cancelled.load(std::memory_order_acquire);
+    }
+
+    bool canBeCancelled() const noexcept
+    {
+        return (nullptr != m_statePtr);
+    }
+
+private:
+    friend class CancellationSource;
+    //the shared state polls the flag without copying the token
+    template <typename Result> friend class SharedState;
+
+    explicit CancellationToken(std::shared_ptr<const cancellation_details::CancellationState> statePtr) noexcept
+        : m_statePtr{std::move(statePtr)}
+    {}
+
+    std::shared_ptr<const cancellation_details::CancellationState> m_statePtr;
+};
+
+/// @brief Requests cancellation of the work observing tokens of this source.
+class CancellationSource
+{
+public:
+    CancellationSource()
+        : m_statePtr{std::make_shared<cancellation_details::CancellationState>()}
+    {}
+
+    CancellationToken getToken() const noexcept
+    {
+        return CancellationToken(m_statePtr);
+    }
+
+    void requestCancellation() noexcept
+    {
+        m_statePtr->m_cancelled.store(true, std::memory_order_release);
+    }
+
+    bool isCancellationRequested() const noexcept
+    {
+        return m_statePtr->m_cancelled.load(std::memory_order_acquire);
+    }
+
+private:
+    std::shared_ptr<cancellation_details::CancellationState> m_statePtr;
+};
+
+}
+
+#endif // CANCELLATION_HPP
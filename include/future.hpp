@@ -4,14 +4,24 @@
 #include <mutex>
 #include <condition_variable>
 #include <optional>
+#include <memory>
+#include <new>
 
 #include <stdexcept>
 #include <functional>
 #include <type_traits>
 #include <atomic>
+#include <cstdint>
+#include <vector>
+#include <iterator>
 
 #include "./utils.hpp"
 #include "./uniquefunction.hpp"
+#include "./cancellation.hpp"
+#include "./stats.hpp"
+#include "./tracing.hpp"
+#include "./trampoline.hpp"
+#include "./try.hpp"
 
 namespace tclib
 {
@@ -22,121 +32,330 @@ public:
     explicit FutureError(FutureErrorCode code) : std::logic_error{toString(code)} {}
 };
 
-template<typename Result>
-class SharedState
+/// Intrusive list node of a coroutine suspended on a shared state.
+/// The node lives in the awaiter object (inside the coroutine frame), the list head lives in the result storage
+/// of the pending state, so registration does not allocate.
+/// @note The node and the list are defined in every build, so the shared state has the same definition
+/// in C++17 and C++20 translation units, only FutureAwaiter creating the node requires C++20.
+struct AwaiterNode
+{
+    coroutine_details::CoroutineRef m_coroutine;
+    AwaiterNode* m_next = nullptr;
+};
+
+/// @brief Continuations and awaiting coroutines of shared states satisfied together, see fulfilAll().
+/// @details The continuations are collected while the states are set and are run later in one go,
+/// e.g. by a single executor job, instead of inline in the thread context of the producer.
+class ContinuationBatch
 {
 public:
-    SharedState() = default;
+    ContinuationBatch() = default;
 
-    SharedState(const SharedState&) = delete;
-    SharedState& operator=(const SharedState&) = delete;
+    ContinuationBatch(const ContinuationBatch&) = delete;
+    ContinuationBatch& operator=(const ContinuationBatch&) = delete;
 
-    SharedState(SharedState&&) = default;
-    SharedState& operator=(SharedState&&) = default;
+    ContinuationBatch(ContinuationBatch&&) = default;
+    ContinuationBatch& operator=(ContinuationBatch&&) = default;
 
-    void setValue(Result result)
+    void reserve(std::size_t size)
     {
-        checkState();
-        m_result = std::move(result);
-        setStateDoneAndNotify();
+        m_continuations.reserve(size);
     }
 
-    void setException(std::exception_ptr exc)
+    void add(UniqueFunction<void()> continuation)
     {
-        checkState();
-        m_exception = std::move(exc);
-        setStateDoneAndNotify();
+        m_continuations.push_back(std::move(continuation));
     }
 
-    void setContinuation(UniqueFunction<void()> continuation)
+    bool empty() const noexcept
     {
-        auto done = false;
+        return m_continuations.empty();
+    }
+
+    std::size_t size() const noexcept
+    {
+        return m_continuations.size();
+    }
+
+    /// @brief Runs the continuations on the trampoline of the current thread in the order they were added,
+    /// the batch is empty afterwards.
+    void run()
+    {
+        auto continuations = std::move(m_continuations);
+        m_continuations.clear();
+        for (auto& continuation : continuations)
         {
-            auto _(std::unique_lock<std::mutex>(m_mutex));
-            done = m_done;
-            if (!done)
+            trampoline_details::run(std::move(continuation));
+        }
+    }
+
+private:
+    std::vector<UniqueFunction<void()>> m_continuations;
+};
+
+/// @brief Empty value of void futures, stored in the shared state of Promise<void>
+/// so one implementation serves all value types.
+/// @details It is the value type of Promise<void>::setValue(Unit) and of the pairs passed to fulfilAll().
+struct Unit {};
+
+namespace future_details
+{
+    template <typename T>
+    using ValueT = std::conditional_t<std::is_void<T>::value, Unit, T>;
+}
+
+/// @brief Part of the shared state independent of the value type: the flags, the mutex and the side block.
+/// @details The state created by then() refers to the state it was created from through it,
+/// so interrupts are passed up a chain of states of different value types.
+class SharedStateBase
+{
+public:
+    SharedStateBase(const SharedStateBase&) = delete;
+    SharedStateBase& operator=(const SharedStateBase&) = delete;
+
+    bool isReady() const noexcept
+    {
+        return 0 != (m_state.load(std::memory_order_acquire) & s_done);
+    }
+
+    /// @brief Sets the handler called on the first interrupt raised by consumer side,
+    /// it is called immediately if the interrupt has been already raised.
+    void setInterruptHandler(UniqueFunction<void(std::exception_ptr)> handler)
+    {
+        std::exception_ptr interrupt;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (isReady())
             {
-                m_then.swap(continuation);
+                return;
+            }
+            auto& extras = getExtras();
+            interrupt = extras.m_interrupt;
+            if (!interrupt)
+            {
+                extras.m_interruptHandler.swap(handler);
             }
         }
-        if (done && continuation)
+        if (interrupt && handler)
         {
-            continuation();
+            handler(std::move(interrupt));
         }
     }
 
-    void resetContinuation()
+    /// @brief Passes the interrupt to the producer side, it is ignored if the state is done
+    /// or an interrupt has been already raised.
+    /// @details Without a handler the interrupt is passed on to the upstream state, see setUpstream().
+    /// The lock of a state is released only after the lock of its upstream is taken and the upstream
+    /// is seen pending, so the upstream cannot be released by its continuation while it is visited.
+    void raise(std::exception_ptr exc)
     {
-        decltype(m_then) continuation;
-        std::unique_lock<std::mutex> lock(m_mutex);
-        m_then.swap(continuation);
+        UniqueFunction<void(std::exception_ptr)> handler;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            if (!interrupt(exc, handler))
+            {
+                return;
+            }
+            auto state = this;
+            while (!handler)
+            {
+                auto upstream = state->upstream();
+                if (!upstream)
+                {
+                    break;
+                }
+                std::unique_lock<std::mutex> upstreamLock(upstream->m_mutex);
+                if (!upstream->interrupt(exc, handler))
+                {
+                    break;
+                }
+                lock = std::move(upstreamLock);
+                state = upstream;
+            }
+        }
+        if (handler)
+        {
+            handler(std::move(exc));
+        }
     }
 
-    void setAndThrowIfRetrieved()
+    /// @brief Passes the interrupts raised on this pending state to the upstream state, e.g. to the state
+    /// of the future this one is created from by then(). The upstream is not owned, the owner of the link
+    /// keeps it alive until the link is reset or this state is done. The link takes the slot of the side block
+    /// pointer until the side block is needed, so it costs no allocation and is resolved only by raise().
+    /// An interrupt already raised on this state is passed to the upstream immediately.
+    void setUpstream(SharedStateBase& upstream)
     {
-        if (m_retrieved.test_and_set())
+        std::exception_ptr interrupt;
         {
-            throw FutureError{FutureErrorCode::future_already_retrieved};
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (isReady())
+            {
+                return;
+            }
+            if (auto extras = loadExtras(std::memory_order_relaxed))
+            {
+                interrupt = extras->m_interrupt;
+                extras->m_upstream = interrupt ? nullptr : &upstream;
+            }
+            else
+            {
+                m_extras.store(reinterpret_cast<std::uintptr_t>(&upstream) | s_upstreamTag, std::memory_order_release);
+            }
+        }
+        if (interrupt)
+        {
+            upstream.raise(std::move(interrupt));
         }
     }
 
-    auto getValue()
+    /// @note only the owner of the link sets it, an empty slot (no link, no side block) is checked without the mutex
+    void resetUpstream()
     {
-        wait();
-        if (m_exception)
+        if (0 == m_extras.load(std::memory_order_acquire))
+        {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (auto extras = loadExtras(std::memory_order_relaxed))
         {
-            std::rethrow_exception(m_exception);
+            extras->m_upstream = nullptr;
+        }
+        else
+        {
+            m_extras.store(0, std::memory_order_release);
         }
-        return  m_result.value();
     }
 
-    void wait() const
+protected:
+    SharedStateBase() = default;
+
+    ~SharedStateBase()
     {
-        std::unique_lock<std::mutex> lock(m_mutex);
-        m_cv.wait(lock, [this](){ return m_done.load();});
+        delete loadExtras(std::memory_order_relaxed);
     }
 
-private:
-    void checkState()
+    /// flags of m_state, the consumer count is stored above them,
+    /// s_value or s_exception records the alternative of the result and is set together with s_done
+    static constexpr std::size_t s_done = 1;
+    static constexpr std::size_t s_retrieved = 2;
+    static constexpr std::size_t s_value = 4;
+    static constexpr std::size_t s_exception = 8;
+    static constexpr std::size_t s_consumer = 16;
+
+    /// Data used only by the producers and consumers that interrupt, cancel or detect abandonment,
+    /// allocated on first use, so the other states carry only the pointer.
+    struct Extras
     {
-        if (m_done)
+        UniqueFunction<void(std::exception_ptr)> m_interruptHandler;
+        UniqueFunction<void()> m_abandonedHandler;
+        std::exception_ptr m_interrupt;
+        CancellationToken m_cancellationToken;
+        //flag of m_cancellationToken, read without the mutex
+        std::atomic<const cancellation_details::CancellationState*> m_cancellationState{nullptr};
+        std::vector<CancellationToken> m_replacedTokens;
+        //moved from m_extras when the side block is allocated
+        SharedStateBase* m_upstream = nullptr;
+    };
+
+    /// @return the side block, nullptr if it is not allocated (the slot is empty or holds the upstream link)
+    Extras* loadExtras(std::memory_order order) const noexcept
+    {
+        const auto extras = m_extras.load(order);
+        return (0 != (extras & s_upstreamTag)) ? nullptr : reinterpret_cast<Extras*>(extras);
+    }
+
+    /// @note called with the mutex locked, the pointer is published for the lock-free checks of isCancellationRequested()
+    /// and of releaseConsumer()
+    Extras& getExtras()
+    {
+        const auto slot = m_extras.load(std::memory_order_relaxed);
+        if (0 != slot && 0 == (slot & s_upstreamTag))
         {
-            throw FutureError{FutureErrorCode::promise_already_satisfied};
+            return *reinterpret_cast<Extras*>(slot);
         }
+        auto extras = new Extras;
+        extras->m_upstream = reinterpret_cast<SharedStateBase*>(slot & ~s_upstreamTag);
+        m_extras.store(reinterpret_cast<std::uintptr_t>(extras), std::memory_order_seq_cst);
+        return *extras;
     }
 
-    void setStateDoneAndNotify()
+    //done and retrieved flags and the consumer count, done is written once by the producer,
+    //the consumer count by the consumers
+    TCLIB_CACHE_LINE_ALIGNED std::atomic<std::size_t> m_state{0};
+#ifdef TCLIB_ENABLE_TRACING
+    TraceContext m_traceContext;
+#endif
+
+    //synchronization and callbacks, accessed under the mutex
+    TCLIB_CACHE_LINE_ALIGNED mutable std::mutex m_mutex;
+    mutable std::condition_variable m_cv;
+    //owned side block, written once under the mutex, or the upstream link tagged by s_upstreamTag
+    std::atomic<std::uintptr_t> m_extras{0};
+
+private:
+    static constexpr std::uintptr_t s_upstreamTag = 1;
+
+    /// @note called with the mutex locked
+    SharedStateBase* upstream() const noexcept
     {
-        decltype(m_then) then;
+        const auto slot = m_extras.load(std::memory_order_relaxed);
+        if (0 != (slot & s_upstreamTag))
         {
-            auto _(std::lock_guard<std::mutex>(m_mutex));
-            m_done = true;
-            then.swap(m_then);
+            return reinterpret_cast<SharedStateBase*>(slot & ~s_upstreamTag);
         }
-        m_cv.notify_all();
+        return (0 != slot) ? reinterpret_cast<Extras*>(slot)->m_upstream : nullptr;
+    }
 
-        if (then)
+    /// Records the interrupt and takes the handler, called with the mutex locked.
+    /// @return false if the state is done or an interrupt has been already raised
+    bool interrupt(const std::exception_ptr& exc, UniqueFunction<void(std::exception_ptr)>& handler)
+    {
+        if (isReady())
         {
-            then();
+            return false;
         }
+        auto& extras = getExtras();
+        if (extras.m_interrupt)
+        {
+            return false;
+        }
+        extras.m_interrupt = exc;
+        handler.swap(extras.m_interruptHandler);
+        return true;
     }
-
-private:
-    std::atomic<bool> m_done{false};
-    std::atomic_flag m_retrieved = ATOMIC_FLAG_INIT;
-    std::optional<Result> m_result;
-    UniqueFunction<void()> m_then;
-    std::exception_ptr m_exception;
-    mutable std::mutex m_mutex;
-    mutable std::condition_variable m_cv;
 };
 
-/// Explicit specialization for SharedState<void>
-template<>
-class SharedState<void>
+/// @brief State shared by the promise and the consumers (futures, continuations, awaiters).
+/// @details The value of SharedState<void> is Unit.
+template<typename Result>
+class SharedState : public SharedStateBase
 {
 public:
-    SharedState() = default;
+    using Value = future_details::ValueT<Result>;
+
+    SharedState()
+    {
+        TCLIB_STATS_ADD(statesConstructed, 1);
+#ifdef TCLIB_ENABLE_TRACING
+        m_traceContext = tracing_details::makeContext();
+        TCLIB_TRACE(onStateCreated, m_traceContext);
+#endif
+    }
+
+    ~SharedState()
+    {
+        TCLIB_STATS_ADD(statesDestructed, 1);
+        const auto state = m_state.load(std::memory_order_relaxed);
+        if (0 != (state & s_value))
+        {
+            std::destroy_at(std::addressof(m_result.m_value));
+        }
+        else if (0 != (state & s_exception))
+        {
+            std::destroy_at(std::addressof(m_result.m_exception));
+        }
+    }
 
     SharedState(const SharedState&) = delete;
     SharedState& operator=(const SharedState&) = delete;
@@ -144,25 +363,69 @@ public:
     SharedState(SharedState&&) = default;
     SharedState& operator=(SharedState&&) = default;
 
-    void setValue()
+    void setValue(Value result)
     {
         checkState();
-        setStateDoneAndNotify();
+        TCLIB_TRACE(onSetValue, m_traceContext);
+        setResultAndNotify(s_value, [this, &result]()
+        {
+            ::new (static_cast<void*>(std::addressof(m_result.m_value))) Value(std::move(result));
+        });
+    }
+
+    /// @brief Sets the value like setValue(), but the continuation and the awaiting coroutines
+    /// are added to the batch instead of being run.
+    void setValue(Value result, ContinuationBatch& batch)
+    {
+        checkState();
+        TCLIB_TRACE(onSetValue, m_traceContext);
+        setResultAndNotify(s_value, [this, &result]()
+        {
+            ::new (static_cast<void*>(std::addressof(m_result.m_value))) Value(std::move(result));
+        }, &batch);
+    }
+
+    template <typename R = Result, typename = std::enable_if_t<std::is_void<R>::value>>
+    void setValue()
+    {
+        setValue(Value{});
+    }
+
+    template <typename R = Result, typename = std::enable_if_t<std::is_void<R>::value>>
+    void setValue(ContinuationBatch& batch)
+    {
+        setValue(Value{}, batch);
     }
 
     void setException(std::exception_ptr exc)
     {
         checkState();
-        m_exception = std::move(exc);
-        setStateDoneAndNotify();
+        TCLIB_STATS_ADD(exceptionsPropagated, 1);
+        TCLIB_TRACE(onSetException, m_traceContext, exc);
+        setResultAndNotify(s_exception, [this, &exc]()
+        {
+            ::new (static_cast<void*>(std::addressof(m_result.m_exception))) std::exception_ptr(std::move(exc));
+        });
+    }
+
+    void setException(std::exception_ptr exc, ContinuationBatch& batch)
+    {
+        checkState();
+        TCLIB_STATS_ADD(exceptionsPropagated, 1);
+        TCLIB_TRACE(onSetException, m_traceContext, exc);
+        setResultAndNotify(s_exception, [this, &exc]()
+        {
+            ::new (static_cast<void*>(std::addressof(m_result.m_exception))) std::exception_ptr(std::move(exc));
+        }, &batch);
     }
 
     void setContinuation(UniqueFunction<void()> continuation)
     {
+        TCLIB_STATS_ADD(continuationsAttached, 1);
         auto done = false;
         {
-            auto _(std::unique_lock<std::mutex>(m_mutex));
-            done = m_done;
+            std::unique_lock<std::mutex> lock(m_mutex);
+            done = isReady();
             if (!done)
             {
                 m_then.swap(continuation);
@@ -170,77 +433,598 @@ public:
         }
         if (done && continuation)
         {
-            continuation();
+            TCLIB_STATS_ADD(continuationsRunInline, 1);
+            runContinuation(std::move(continuation));
         }
     }
 
-    void resetContinuation()
+    void setAndThrowIfRetrieved()
     {
-        decltype(m_then) continuation;
-        auto _(std::unique_lock<std::mutex>(m_mutex));
-        m_then.swap(continuation);
+        if (0 != (m_state.fetch_or(s_retrieved, std::memory_order_acq_rel) & s_retrieved))
+        {
+            throw FutureError{FutureErrorCode::future_already_retrieved};
+        }
     }
 
-    void setAndThrowIfRetrieved()
+    void addConsumer() noexcept
+    {
+        m_state.fetch_add(s_consumer, std::memory_order_relaxed);
+    }
+
+    /// @note the mutex is locked only if the side block exists, the order of the consumer count
+    /// and of the side block pointer is sequentially consistent, see setAbandonedHandler()
+    void releaseConsumer()
     {
-        if (m_retrieved.test_and_set())
+        if (1 == m_state.fetch_sub(s_consumer, std::memory_order_seq_cst) / s_consumer)
         {
-            throw FutureError{FutureErrorCode::future_already_retrieved};
+            auto extras = loadExtras(std::memory_order_seq_cst);
+            if (!extras)
+            {
+                return;
+            }
+            UniqueFunction<void()> handler;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (isReady())
+                {
+                    return;
+                }
+                handler.swap(extras->m_abandonedHandler);
+            }
+            if (handler)
+            {
+                handler();
+            }
+        }
+    }
+
+    /// @return true if the future has been retrieved and all futures, continuations
+    /// and awaiters referring to the state are gone
+    bool isAbandoned() const noexcept
+    {
+        const auto state = m_state.load(std::memory_order_acquire);
+        return (0 != (state & s_retrieved)) && (state < s_consumer);
+    }
+
+    /// @return true if the result can be read: the future has been retrieved and a future, continuation
+    /// or awaiter refers to the state (continuations and awaiters hold the state as consumers too)
+    bool isObserved() const noexcept
+    {
+        const auto state = m_state.load(std::memory_order_acquire);
+        return (0 != (state & s_retrieved)) && (state >= s_consumer);
+    }
+
+    /// @brief Sets the handler called when the state is abandoned,
+    /// it is called immediately if the state is already abandoned.
+    void setAbandonedHandler(UniqueFunction<void()> handler)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (isReady())
+            {
+                return;
+            }
+            if (!isAbandoned())
+            {
+                auto& extras = getExtras();
+                extras.m_abandonedHandler.swap(handler);
+                //the last consumer may have been released without the mutex before the side block was published,
+                //then the state is seen abandoned here and the handler is taken back
+                const auto state = m_state.load(std::memory_order_seq_cst);
+                if ((0 == (state & s_retrieved)) || (state >= s_consumer))
+                {
+                    return;
+                }
+                handler = std::move(extras.m_abandonedHandler);
+            }
+        }
+        if (handler)
+        {
+            handler();
         }
     }
 
-    void getValue()
+    Result getValue()
     {
         wait();
-        if (m_exception)
+        if (hasException())
         {
-            std::rethrow_exception(m_exception);
+            std::rethrow_exception(m_result.m_exception);
+        }
+        if constexpr (!std::is_void<Result>::value)
+        {
+            return m_result.m_value;
         }
     }
 
     void wait() const
     {
+        if (!isReady())
+        {
+            //the state can be completed by a continuation queued on the trampoline of this thread
+            trampoline_details::runQueued();
+        }
         std::unique_lock<std::mutex> lock(m_mutex);
-        m_cv.wait(lock, [this](){ return m_done.load();});
+#ifdef TCLIB_ENABLE_STATS
+        if (!isReady())
+        {
+            const auto start = stats_details::now();
+            //counted under the mutex, a producer that sees the waiter blocked sets the state after it is parked
+            TCLIB_STATS_ADD(blockingWaitsStarted, 1);
+            m_cv.wait(lock, [this](){ return isReady(); });
+            TCLIB_LATENCY_RECORD(setToWake, m_setTime);
+            TCLIB_STATS_ADD(blockingWaits, 1);
+            TCLIB_STATS_ADD(blockedNanoseconds, stats_details::nanosecondsSince(start));
+            return;
+        }
+#endif
+        m_cv.wait(lock, [this](){ return isReady(); });
+    }
+
+    /// @brief Returns the exception of the done state without rethrowing it, nullptr if it holds a value.
+    std::exception_ptr getException() const
+    {
+        return hasException() ? m_result.m_exception : nullptr;
+    }
+
+    /// @brief Moves the value out of the done state, for the only consumer of the state.
+    Value takeValue()
+    {
+        return std::move(m_result.m_value);
+    }
+
+    /// @brief Returns the result of the done state without rethrowing the exception.
+    Try<Result> getTry() const
+    {
+        if (hasException())
+        {
+            return Try<Result>(m_result.m_exception);
+        }
+        if constexpr (std::is_void<Result>::value)
+        {
+            return Try<Result>();
+        }
+        else
+        {
+            return Try<Result>(m_result.m_value);
+        }
+    }
+
+    /// @brief Moves the result out of the done state, for the only consumer of the state.
+    Try<Result> takeTry()
+    {
+        if constexpr (std::is_void<Result>::value)
+        {
+            return getTry();
+        }
+        else
+        {
+            return hasException() ? Try<Result>(m_result.m_exception) : Try<Result>(takeValue());
+        }
+    }
+
+#ifdef TCLIB_ENABLE_TRACING
+    const TraceContext& traceContext() const noexcept
+    {
+        return m_traceContext;
+    }
+#endif
+
+    /// @note the token can be attached by the consumer while the producer checks it, the flag of the token
+    /// is published for isCancellationRequested() and a replaced token is kept alive until the state is destroyed
+    void setCancellationToken(CancellationToken token)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto& extras = getExtras();
+        extras.m_cancellationState.store(token.m_statePtr.get(), std::memory_order_release);
+        if (extras.m_cancellationToken.canBeCancelled())
+        {
+            extras.m_replacedTokens.push_back(std::move(extras.m_cancellationToken));
+        }
+        extras.m_cancellationToken = std::move(token);
+    }
+
+    CancellationToken getCancellationToken() const
+    {
+        if (!loadExtras(std::memory_order_acquire))
+        {
+            return CancellationToken();
+        }
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return loadExtras(std::memory_order_relaxed)->m_cancellationToken;
+    }
+
+    /// @brief Lock-free, reads the flag of the attached token.
+    bool isCancellationRequested() const noexcept
+    {
+        const auto extras = loadExtras(std::memory_order_acquire);
+        if (!extras)
+        {
+            return false;
+        }
+        const auto state = extras->m_cancellationState.load(std::memory_order_acquire);
+        return state && state->m_cancelled.load(std::memory_order_acquire);
+    }
+
+    /// @return false if the state is already done and the coroutine should not be suspended
+    bool addAwaiter(AwaiterNode& awaiter)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (isReady())
+        {
+            return false;
+        }
+        awaiter.m_next = m_result.m_awaiters;
+        m_result.m_awaiters = &awaiter;
+        return true;
     }
 
 private:
+    /// Value or exception, the discriminator is kept in m_state instead of a variant index,
+    /// so the result takes only the size of the larger alternative.
+    /// Until the state is done the storage holds the list of awaiting coroutines,
+    /// the list is taken and the result is constructed under the mutex.
+    union ResultStorage
+    {
+        ResultStorage() noexcept : m_awaiters{nullptr} {}
+        ~ResultStorage() {}
+
+        Value m_value;
+        std::exception_ptr m_exception;
+        AwaiterNode* m_awaiters;
+    };
+
+    /// @note for the done state only
+    bool hasException() const noexcept
+    {
+        return 0 != (m_state.load(std::memory_order_acquire) & s_exception);
+    }
+
+#if defined(TCLIB_ENABLE_TRACING) || defined(TCLIB_ENABLE_LATENCY_STATS)
+    /// The shared states created by the continuation are traced as children of this one.
+    /// The instrumented continuation can outlive the state, the instrumentation data is copied.
+    auto instrument(UniqueFunction<void()> continuation) const
+    {
+        return [c = std::move(continuation)
+#ifdef TCLIB_ENABLE_TRACING
+                , context = m_traceContext
+#endif
+#ifdef TCLIB_ENABLE_LATENCY_STATS
+                , setTime = m_setTime
+#endif
+               ]() mutable
+        {
+            TCLIB_LATENCY_RECORD(setToContinuationStart, setTime);
+            TCLIB_TRACE(onContinuationStart, context);
+            {
+                TCLIB_TRACE_SCOPE(context);
+                c();
+            }
+            TCLIB_TRACE(onContinuationEnd, context);
+        };
+    }
+#else
+    static UniqueFunction<void()> instrument(UniqueFunction<void()> continuation) noexcept
+    {
+        return continuation;
+    }
+#endif
+
+    /// @brief Runs the continuation (or resumes the awaiting coroutine) on the trampoline of the current thread,
+    /// or adds it to the batch if there is one.
+    void runContinuation(UniqueFunction<void()> continuation, ContinuationBatch* batch = nullptr)
+    {
+        if (batch)
+        {
+            batch->add(instrument(std::move(continuation)));
+            return;
+        }
+        //the instrumented continuation is type erased (and allocated) only if it is queued
+        trampoline_details::run(instrument(std::move(continuation)));
+    }
+
     void checkState()
     {
-        if (m_done)
+        if (isReady())
         {
             throw FutureError{FutureErrorCode::promise_already_satisfied};
         }
     }
 
-    void setStateDoneAndNotify()
+    /// @param result s_value or s_exception, the alternative of m_result constructed by construct()
+    /// @note the result replaces the list of awaiters in m_result, so it is constructed under the mutex,
+    /// if the construction throws the list is restored and the state stays pending
+    template <typename Construct>
+    void setResultAndNotify(std::size_t result, Construct construct, ContinuationBatch* batch = nullptr)
     {
         decltype(m_then) then;
+        UniqueFunction<void(std::exception_ptr)> handler;
+        UniqueFunction<void()> abandonedHandler;
+        AwaiterNode* awaiters = nullptr;
         {
-            auto _(std::lock_guard<std::mutex>(m_mutex));
-            m_done = true;
+            std::lock_guard<std::mutex> lock(m_mutex);
+            //checked again, the result is constructed only once if producers race
+            checkState();
+            awaiters = m_result.m_awaiters;
+            try
+            {
+                construct();
+            }
+            catch (...)
+            {
+                m_result.m_awaiters = awaiters;
+                throw;
+            }
+#ifdef TCLIB_ENABLE_LATENCY_STATS
+            m_setTime = stats_details::now();
+#endif
+            m_state.fetch_or(s_done | result, std::memory_order_acq_rel);
             then.swap(m_then);
+            if (auto extras = loadExtras(std::memory_order_relaxed))
+            {
+                handler.swap(extras->m_interruptHandler);
+                abandonedHandler.swap(extras->m_abandonedHandler);
+            }
         }
         m_cv.notify_all();
 
         if (then)
         {
-            then();
+            runContinuation(std::move(then), batch);
+        }
+        resumeAwaiters(awaiters, batch);
+    }
+
+    void resumeAwaiters(AwaiterNode* awaiters, ContinuationBatch* batch)
+    {
+        //awaiters are registered in reverse order, resume them in the order of registration
+        AwaiterNode* ordered = nullptr;
+        while (awaiters)
+        {
+            auto next = awaiters->m_next;
+            awaiters->m_next = ordered;
+            ordered = awaiters;
+            awaiters = next;
+        }
+        while (ordered)
+        {
+            //the node is destroyed together with the coroutine frame, read the next one before resume
+            auto next = ordered->m_next;
+            runContinuation(ordered->m_coroutine, batch);
+            ordered = next;
         }
     }
 
 private:
-    std::atomic<bool> m_done{false};
-    std::atomic_flag m_retrieved = ATOMIC_FLAG_INIT;
+    //The members are grouped by the side that writes them, the flags and the mutex group are in SharedStateBase.
+    //With TCLIB_ENABLE_CACHE_LINE_LAYOUT every group starts on its own cache line (and so does the state),
+    //so the consumers polling the flags do not contend with the producer writing the result or with the threads
+    //holding the mutex. Without it the result fills the end of the base and the continuation follows it.
+
+    //result written by the producer before the state is done, the alternative is recorded by the flags of m_state
+    TCLIB_CACHE_LINE_ALIGNED ResultStorage m_result;
+#ifdef TCLIB_ENABLE_LATENCY_STATS
+    std::chrono::steady_clock::time_point m_setTime;
+#endif
+
+    //accessed under the mutex
     UniqueFunction<void()> m_then;
-    std::exception_ptr m_exception;
-    mutable std::mutex m_mutex;
-    mutable std::condition_variable m_cv;
 };
 
-
 template <typename T> class Future;
 template <typename T> class SharedFuture;
+template <typename T> class Promise;
+template <typename Signature> class PackagedTask;
+template <typename T> class PromiseArray;
+template <typename T> class FutureArray;
+
+namespace deferred_details
+{
+    /// The first stage of a deferred pipeline, returns the value of the future.
+    struct GetValue
+    {
+        template <typename T>
+        T operator()(Future<T>&& future) const
+        {
+            return future.get();
+        }
+    };
+}
+
+template <typename T, typename Pipeline = deferred_details::GetValue> class DeferredFuture;
+
+namespace future_details
+{
+    template <typename R>
+    struct IsFuture : std::false_type {};
+
+    template <typename T>
+    struct IsFuture<Future<T>> : std::true_type {};
+
+    /// The result type of a continuation, the future returned by the function object is unwrapped.
+    template <typename R>
+    struct Unwrap
+    {
+        using type = R;
+    };
+
+    template <typename T>
+    struct Unwrap<Future<T>>
+    {
+        using type = T;
+    };
+
+    template <typename R>
+    using UnwrapT = typename Unwrap<R>::type;
+
+    /// The result type of a continuation receiving the value of Future<T>, nothing for Future<void>.
+    template <typename F, typename T>
+    struct ValueResult
+    {
+        using type = std::invoke_result_t<F, T&&>;
+    };
+
+    template <typename F>
+    struct ValueResult<F, void>
+    {
+        using type = std::invoke_result_t<F>;
+    };
+
+    template <typename F, typename T>
+    using ValueResultT = typename ValueResult<F, T>::type;
+
+    template <typename Range, typename = void>
+    struct HasSize : std::false_type {};
+
+    template <typename Range>
+    struct HasSize<Range, std::void_t<decltype(std::size(std::declval<Range&>()))>> : std::true_type {};
+
+    /// Sets the result of the function object call to the promise, void result sets the promise without value.
+    /// The future returned by the function object completes the promise directly, without an intermediate state.
+    template <typename R, typename F, typename... Arg>
+    void setResult(Promise<R>& promise, F& f, Arg&&... arg)
+    {
+        if constexpr (IsFuture<std::invoke_result_t<F&, Arg&&...>>::value)
+        {
+            f(std::forward<Arg>(arg)...).forwardTo(promise);
+        }
+        else if constexpr (std::is_void<R>::value)
+        {
+            f(std::forward<Arg>(arg)...);
+            promise.setValue();
+        }
+        else
+        {
+            promise.setValue(f(std::forward<Arg>(arg)...));
+        }
+    }
+}
+
+/// @brief Shared pointer to the shared state held by the consumer side (futures, continuations, awaiters).
+/// @details Maintains the consumer count of the shared state, so the producer can detect
+/// that nobody will read the result (see Promise::isAbandoned()).
+template <typename T>
+class ConsumerStatePtr
+{
+public:
+    ConsumerStatePtr() = default;
+
+    explicit ConsumerStatePtr(std::shared_ptr<SharedState<T>> sharedStatePtr) noexcept
+        : m_statePtr{std::move(sharedStatePtr)}
+    {
+        if (m_statePtr)
+        {
+            m_statePtr->addConsumer();
+        }
+    }
+
+    ~ConsumerStatePtr()
+    {
+        reset();
+    }
+
+    ConsumerStatePtr(const ConsumerStatePtr& other) noexcept
+        : ConsumerStatePtr(other.m_statePtr)
+    {}
+
+    ConsumerStatePtr& operator=(const ConsumerStatePtr& other)
+    {
+        if (this != std::addressof(other))
+        {
+            ConsumerStatePtr tmp(other);
+            *this = std::move(tmp);
+        }
+        return *this;
+    }
+
+    ConsumerStatePtr(ConsumerStatePtr&&) noexcept = default;
+
+    ConsumerStatePtr& operator=(ConsumerStatePtr&& other)
+    {
+        if (this != std::addressof(other))
+        {
+            reset();
+            m_statePtr = std::move(other.m_statePtr);
+        }
+        return *this;
+    }
+
+    void reset()
+    {
+        if (auto statePtr = std::move(m_statePtr))
+        {
+            statePtr->releaseConsumer();
+        }
+    }
+
+    const std::shared_ptr<SharedState<T>>& sharedPtr() const noexcept
+    {
+        return m_statePtr;
+    }
+
+    SharedState<T>* operator->() const noexcept
+    {
+        return m_statePtr.get();
+    }
+
+    explicit operator bool() const noexcept
+    {
+        return static_cast<bool>(m_statePtr);
+    }
+
+private:
+    std::shared_ptr<SharedState<T>> m_statePtr;
+};
+
+#if TCLIB_HAS_COROUTINES
+/// @brief Awaiter returned by operator co_await of Future and SharedFuture.
+/// @details The suspended coroutine is registered directly in the shared state
+/// and resumed in the thread context of the promise object.
+/// The awaiter of Future is the only consumer of the state and moves the value out of it,
+/// the awaiter of SharedFuture (Shared is true) returns a copy.
+template <typename T, bool Shared = false>
+class FutureAwaiter
+{
+public:
+    explicit FutureAwaiter(ConsumerStatePtr<T> sharedStatePtr) noexcept
+        : m_statePtr{std::move(sharedStatePtr)}
+    {}
+
+    bool await_ready() const noexcept
+    {
+        return m_statePtr->isReady();
+    }
+
+    bool await_suspend(std::coroutine_handle<> handle)
+    {
+        m_node.m_coroutine = coroutine_details::makeCoroutineRef(handle);
+        return m_statePtr->addAwaiter(m_node);
+    }
+
+    T await_resume()
+    {
+        if constexpr (Shared)
+        {
+            return m_statePtr->getValue();
+        }
+        else
+        {
+            if (auto exc = m_statePtr->getException())
+            {
+                std::rethrow_exception(std::move(exc));
+            }
+            if constexpr (!std::is_void<T>::value)
+            {
+                return m_statePtr->takeValue();
+            }
+        }
+    }
+
+private:
+    ConsumerStatePtr<T> m_statePtr;
+    AwaiterNode m_node;
+};
+#endif
 
 template <typename T>
 class Promise
@@ -250,49 +1034,183 @@ public:
         : m_statePtr{std::make_shared<SharedState<T>>()}
     {}
 
+private:
+    template <typename Signature> friend class PackagedTask;
+    template <typename U> friend class PromiseArray;
+    template <typename U> friend class Future;
+
+    /// The shared state can be allocated together with other objects, e.g. by PackagedTask or PromiseArray.
+    explicit Promise(std::shared_ptr<SharedState<T>> sharedStatePtr) noexcept
+        : m_statePtr{std::move(sharedStatePtr)}
+    {}
+
+    /// The interrupts raised on the futures of this promise are passed to the upstream state,
+    /// see SharedStateBase::setUpstream().
+    void setUpstream(SharedStateBase& upstream)
+    {
+        m_statePtr->setUpstream(upstream);
+    }
+
+    void resetUpstream()
+    {
+        m_statePtr->resetUpstream();
+    }
+
+public:
+
     ~Promise()
     {
-        if (m_statePtr)
+        //the error is not stored if nobody can read it, so dropping an unused promise does not allocate
+        if (m_statePtr && !m_statePtr->isReady() && m_statePtr->isObserved())
         {
-            //remove cyclic dependency between shared states,
+            //waiters and continuations get broken_promise error instead of waiting forever,
+            //running the continuation also removes cyclic dependency between shared states,
             //case when {Promise<int> p; auto f = p.then(...); and no call to p.setValue();
-            m_statePtr->resetContinuation();
+            m_statePtr->setException(std::make_exception_ptr(FutureError{FutureErrorCode::broken_promise}));
+        }
+    }
+
+   Promise(const Promise&) = delete;
+   Promise& operator=(const Promise&) = delete;
+
+   Promise(Promise&&) = default;
+   Promise& operator=(Promise&& other)
+   {
+       if (this != std::addressof(other))
+       {
+           //the shared state of this promise is broken by the destructor of the temporary
+           Promise tmp(std::move(*this));
+           m_statePtr = std::move(other.m_statePtr);
+       }
+       return *this;
+   }
+
+    void setValue(future_details::ValueT<T> value)
+    {
+        if (!m_statePtr)
+        {
+            throw FutureError{FutureErrorCode::no_state};
+        }
+        m_statePtr->setValue(std::move(value));
+    }
+
+    /// @brief Sets the value like setValue(), but the continuation and the awaiting coroutines
+    /// are added to the batch instead of being run, see fulfilAll().
+    void setValue(future_details::ValueT<T> value, ContinuationBatch& batch)
+    {
+        if (!m_statePtr)
+        {
+            throw FutureError{FutureErrorCode::no_state};
+        }
+        m_statePtr->setValue(std::move(value), batch);
+    }
+
+    /// @brief Sets the value of Promise<void>.
+    template <typename U = T, typename = std::enable_if_t<std::is_void<U>::value>>
+    void setValue()
+    {
+        setValue(Unit{});
+    }
+
+    template <typename U = T, typename = std::enable_if_t<std::is_void<U>::value>>
+    void setValue(ContinuationBatch& batch)
+    {
+        setValue(Unit{}, batch);
+    }
+
+    Future<T> getFuture()
+    {
+        if (!m_statePtr)
+        {
+            throw FutureError{FutureErrorCode::no_state};
+        }
+        m_statePtr->setAndThrowIfRetrieved();
+
+        return Future<T>(ConsumerStatePtr<T>(m_statePtr));
+    }
+
+    void setException(std::exception_ptr exc)
+    {
+        if (!m_statePtr)
+        {
+            throw FutureError{FutureErrorCode::no_state};
+        }
+        m_statePtr->setException(exc);
+    }
+
+    void setException(std::exception_ptr exc, ContinuationBatch& batch)
+    {
+        if (!m_statePtr)
+        {
+            throw FutureError{FutureErrorCode::no_state};
+        }
+        m_statePtr->setException(exc, batch);
+    }
+
+    void setTry(Try<T> result)
+    {
+        if (result.hasException())
+        {
+            setException(result.exception());
+            return;
+        }
+        if constexpr (std::is_void<T>::value)
+        {
+            setValue();
+        }
+        else
+        {
+            setValue(std::move(result).value());
         }
     }
 
-   Promise(const Promise&) = delete;
-   Promise& operator=(const Promise&) = delete;
-
-   Promise(Promise&&) = default;
-   Promise& operator=(Promise&&) = default;
-
-    void setValue(T value)
+    /// @brief Attaches the cancellation token to the shared state,
+    /// it is propagated to the futures created by then().
+    void setCancellationToken(CancellationToken token)
     {
         if (!m_statePtr)
         {
             throw FutureError{FutureErrorCode::no_state};
         }
-        m_statePtr->setValue(std::move(value));
+        m_statePtr->setCancellationToken(std::move(token));
     }
 
-    Future<T> getFuture()
+    /// @brief Cheap check for producers whether the result is still needed.
+    bool isCancellationRequested() const noexcept
+    {
+        return m_statePtr && m_statePtr->isCancellationRequested();
+    }
+
+    /// @brief Sets the handler called when the consumer raises an interrupt (e.g. Future::cancel()),
+    /// so the producer can abort the work. The handler is called at most once, in the thread context
+    /// of the consumer, and is released when the promise is satisfied. The interrupts raised on the futures
+    /// created by then() reach the handler whether it is set before or after then() is called,
+    /// an interrupt raised before the handler is set is kept and passed to it when it is set.
+    void setInterruptHandler(UniqueFunction<void(std::exception_ptr)> handler)
     {
         if (!m_statePtr)
         {
             throw FutureError{FutureErrorCode::no_state};
         }
-        m_statePtr->setAndThrowIfRetrieved();
+        m_statePtr->setInterruptHandler(std::move(handler));
+    }
 
-        return Future<T>(m_statePtr);
+    /// @brief Cheap check for producers whether anybody will read the result,
+    /// true if the future has been retrieved and all futures, continuations and awaiters are gone.
+    bool isAbandoned() const noexcept
+    {
+        return m_statePtr && m_statePtr->isAbandoned();
     }
 
-    void setException(std::exception_ptr exc)
+    /// @brief Sets the handler called when the shared state is abandoned, in the thread context
+    /// of the last consumer. The handler is released when the promise is satisfied.
+    void setAbandonedHandler(UniqueFunction<void()> handler)
     {
         if (!m_statePtr)
         {
             throw FutureError{FutureErrorCode::no_state};
         }
-        m_statePtr->setException(exc);
+        m_statePtr->setAbandonedHandler(std::move(handler));
     }
 
 private:
@@ -304,8 +1222,11 @@ class Future
 {
 private:
     friend class Promise<T>;
+    template <typename U> friend class FutureArray;
+    template <typename R, typename F, typename... Arg>
+    friend void future_details::setResult(Promise<R>&, F&, Arg&&...);
 
-    Future(std::shared_ptr<SharedState<T>> sharedStatePtr)
+    explicit Future(ConsumerStatePtr<T> sharedStatePtr) noexcept
         : m_statePtr{std::move(sharedStatePtr)}
     {}
 
@@ -330,6 +1251,19 @@ public:
         return statePtr->getValue();
     }
 
+    /// @brief Waits for the result and returns it without rethrowing the exception,
+    /// the future is invalid afterwards.
+    Try<T> getTry()
+    {
+        if (!m_statePtr)
+        {
+            throw FutureError{FutureErrorCode::no_state};
+        }
+        auto statePtr = std::move(m_statePtr);
+        statePtr->wait();
+        return statePtr->takeTry();
+    }
+
     void wait()
     {
         if (!m_statePtr)
@@ -341,11 +1275,51 @@ public:
 
     bool valid() const noexcept
     {
-        return (nullptr != m_statePtr);
+        return static_cast<bool>(m_statePtr);
     }
 
     SharedFuture<T> share() noexcept;
 
+    /// @brief Attaches the cancellation token to the shared state,
+    /// it is propagated to the futures created by then().
+    void setCancellationToken(CancellationToken token)
+    {
+        if (!m_statePtr)
+        {
+            throw FutureError{FutureErrorCode::no_state};
+        }
+        m_statePtr->setCancellationToken(std::move(token));
+    }
+
+    /// @brief Passes the interrupt to the interrupt handler of the promise, the future stays valid.
+    /// The interrupt is propagated to the futures this future was created from by then().
+    void raise(std::exception_ptr exc)
+    {
+        if (!m_statePtr)
+        {
+            throw FutureError{FutureErrorCode::no_state};
+        }
+        m_statePtr->raise(std::move(exc));
+    }
+
+    /// @brief Raises FutureError{cancelled} interrupt.
+    void cancel()
+    {
+        raise(std::make_exception_ptr(FutureError{FutureErrorCode::cancelled}));
+    }
+
+#if TCLIB_HAS_COROUTINES
+    /// @brief Suspends the coroutine until the shared state is ready, the future is invalid afterwards.
+    FutureAwaiter<T> operator co_await() &&
+    {
+        if (!m_statePtr)
+        {
+            throw FutureError{FutureErrorCode::no_state};
+        }
+        return FutureAwaiter<T>(std::move(m_statePtr));
+    }
+#endif
+
     /// @brief Creates a continuation on the current thread.
     /// @return a future of type of the result type of passed function object
     /// @details Creates new promise/future pair and the new future is returned.
@@ -355,169 +1329,160 @@ public:
     /// Finally the shared state object is referenced by promise and continuation objects.
     /// This structure is similar to a linked list, the shared state object has a continuation
     /// that points to next promise object (next node in the linked list).
-    /// Continuation is executed in the tread context of promise object.
+    /// Continuation is executed in the tread context of promise object,
+    /// continuations of a long chain run on the trampoline of the thread, so the stack depth is bounded.
+    /// The cancellation token of this future is propagated to the new one, if cancellation is requested
+    /// the passed function object is not called and the new future holds FutureError{cancelled}.
+    /// Interrupts raised on the new future are passed to the shared state of this future while it is not done,
+    /// they reach the interrupt handler of its promise whether the handler is set before or after this call,
+    /// an interrupt raised before the handler is set is kept by the state and passed to the handler when it is set.
+    /// The continuation runs even if the new future is discarded, it holds this shared state,
+    /// so the state is not abandoned while the continuation is attached.
+    /// If the function object returns Future<U> the new future is Future<U> completed directly by the returned one.
     template<typename F>
     auto then(F f)
     {
-        if (!m_statePtr)
+        using R = future_details::UnwrapT<decltype(f(Future<T>()))>;
+        return continueWith<R>([f = std::move(f)](ConsumerStatePtr<T>& state, Promise<R>& promise) mutable
         {
-            throw FutureError{FutureErrorCode::no_state};
-        }
-        using R = decltype(f(Future<T>()));
+            future_details::setResult(promise, f, Future<T>(std::move(state)));
+        });
+    }
 
-        Promise<R> promise;
-        Future<R> future = promise.getFuture();
-        UniqueFunction<void()> continuation =
-        [state = m_statePtr, p = std::move(promise), f = std::move(f)]() mutable
+    /// @brief Creates a continuation receiving the value of this future (nothing for Future<void>).
+    /// @details If this future holds an exception the passed function object is not called
+    /// and the exception is passed to the new future without rethrowing it.
+    /// Cancellation and interrupts are handled as by then().
+    template<typename F>
+    auto thenValue(F f)
+    {
+        using R = future_details::UnwrapT<future_details::ValueResultT<F, T>>;
+        return continueWith<R>([f = std::move(f)](ConsumerStatePtr<T>& state, Promise<R>& promise) mutable
         {
-            try
+            if (auto exc = state->getException())
             {
-                Future<T> futureContinuation(std::move(state));
-                p.setValue(f(std::move(futureContinuation)));
+                promise.setException(std::move(exc));
+                return;
             }
-            catch (...)
+            if constexpr (std::is_void<T>::value)
             {
-                p.setException(std::current_exception());
+                future_details::setResult(promise, f);
             }
-        };
-        auto state = std::move(m_statePtr);
-        state->setContinuation(std::move(continuation));
-        return future;
+            else
+            {
+                future_details::setResult(promise, f, state->takeValue());
+            }
+        });
     }
 
-private:
-    std::shared_ptr<SharedState<T>> m_statePtr;
-};
-
-template <typename T>
-class SharedFuture
-{
-private:
-    friend class Future<T>;
-
-    explicit SharedFuture(std::shared_ptr<SharedState<T>> sharedStatePtr) noexcept
-        : m_statePtr{std::move(sharedStatePtr)}
-    {}
-
-public:
-    SharedFuture() = default;
-
-    explicit SharedFuture(Future<T>&& other) noexcept
-        : SharedFuture(other.share())
-    { }
-
-    SharedFuture(const SharedFuture&) = default;
-    SharedFuture& operator=(const SharedFuture&) = default;
-
-    SharedFuture(SharedFuture&&) = default;
-    SharedFuture& operator=(SharedFuture&&) = default;
-
-    T get()
+    /// @brief Creates a continuation receiving the result of this future as Try<T>&&.
+    /// @details The exception is passed in Try without rethrowing it, only the exception thrown
+    /// by the passed function object is caught. Cancellation and interrupts are handled as by then().
+    template<typename F>
+    auto thenTry(F f)
     {
-        if (!m_statePtr)
+        using R = future_details::UnwrapT<std::invoke_result_t<F, Try<T>&&>>;
+        return continueWith<R>([f = std::move(f)](ConsumerStatePtr<T>& state, Promise<R>& promise) mutable
         {
-            throw FutureError{FutureErrorCode::no_state};
-        }
-        return m_statePtr->getValue();
+            future_details::setResult(promise, f, state->takeTry());
+        });
     }
 
-    void wait() const
+    /// @brief Creates a continuation handling the exception of type E held by this future.
+    /// @details The passed function object is called with E& and returns the replacement value
+    /// (void for Future<void>), a value or an exception of other type is passed to the new future unchanged.
+    /// Cancellation and interrupts are handled as by then().
+    template<typename E, typename F>
+    Future<T> thenError(F f)
     {
-        if (!m_statePtr)
+        return continueWith<T>([f = std::move(f)](ConsumerStatePtr<T>& state, Promise<T>& promise) mutable
         {
-            throw FutureError{FutureErrorCode::no_state};
-        }
-        return m_statePtr->wait();
-    }
-
-    bool valid() const noexcept
-    {
-        return (nullptr != m_statePtr);
+            auto exc = state->getException();
+            if (!exc)
+            {
+                promise.setValue(state->takeValue());
+                return;
+            }
+            //the type of the exception can be checked only by rethrowing it
+            try
+            {
+                std::rethrow_exception(exc);
+            }
+            catch (E& e)
+            {
+                future_details::setResult(promise, f, e);
+            }
+            catch (...)
+            {
+                promise.setException(std::move(exc));
+            }
+        });
     }
 
-private:
-    std::shared_ptr<SharedState<T>> m_statePtr;
-};
-
-template <> class Future<void>;
-template <> class SharedFuture<void>;
-
-/// Explicit specialization for Future<void>
-template <>
-class Future<void>
-{
-private:
-    friend class Promise<void>;
-
-    Future(std::shared_ptr<SharedState<void>> sharedStatePtr)
-        : m_statePtr{std::move(sharedStatePtr)}
-    {}
-
-public:
-    Future() = default;
-
-    ~Future() = default;
-
-    Future(const Future&) = delete;
-    Future& operator=(const Future&) = delete;
-
-    Future(Future&&) = default;
-    Future& operator=(Future&&) = default;
-
-    void get()
+    /// @brief Starts a deferred pipeline of continuations, the future is invalid afterwards.
+    /// @details The continuations attached to the pipeline are fused into a single continuation,
+    /// see DeferredFuture.
+    DeferredFuture<T> defer() &&
     {
         if (!m_statePtr)
         {
             throw FutureError{FutureErrorCode::no_state};
         }
-        auto statePtr = std::move(m_statePtr);
-        return statePtr->getValue();
+        return DeferredFuture<T>(std::move(*this));
     }
 
-    void wait()
+private:
+    /// Completes the promise with the result of this future by a continuation of this shared state,
+    /// the interrupts raised on the futures of the promise are passed to this shared state while it is not done.
+    /// The promise is moved only if the future is valid.
+    void forwardTo(Promise<T>& promise)
     {
         if (!m_statePtr)
         {
             throw FutureError{FutureErrorCode::no_state};
         }
-        return m_statePtr->wait();
-    }
-
-    bool valid() const noexcept
-    {
-        return (nullptr != m_statePtr);
+        forwardInterrupts(promise);
+        UniqueFunction<void()> continuation = [state = m_statePtr, p = std::move(promise)]() mutable
+        {
+            p.resetUpstream();
+            p.setTry(state->takeTry());
+        };
+        auto state = std::move(m_statePtr);
+        state->setContinuation(std::move(continuation));
     }
 
-    SharedFuture<void> share() noexcept;
-
-    /// @brief Creates a continuation on the current thread.
-    /// @return a future of type of the result type of passed function object
-    /// @details Creates new promise/future pair and the new future is returned.
-    /// Creates a continuation that holds a shared pointer to shared state object
-    /// and the new promise object. Assign continuation to shared state object.
-    /// Reset the shared pointer that is referring to shared state of this future.
-    /// Finally the shared state object is referenced by promise and continuation objects.
-    /// This structure is similar to a linked list, the shared state object has a continuation
-    /// that points to next promise object (next node in the linked list).
-    /// Continuation is executed in the tread context of promise object.
-    template<typename F>
-    auto then(F f)
+    /// Attaches the continuation calling onReady(state, promise) to the shared state when it is ready,
+    /// exceptions thrown by onReady are passed to the new future.
+    template <typename R, typename C>
+    Future<R> continueWith(C onReady)
     {
         if (!m_statePtr)
         {
             throw FutureError{FutureErrorCode::no_state};
         }
-        using R = decltype(f(Future<void>()));
 
+        TCLIB_TRACE_SCOPE(m_statePtr->traceContext());
         Promise<R> promise;
+        //the token is attached only if used
+        if (auto token = m_statePtr->getCancellationToken(); token.canBeCancelled())
+        {
+            promise.setCancellationToken(std::move(token));
+        }
+        forwardInterrupts(promise);
         Future<R> future = promise.getFuture();
         UniqueFunction<void()> continuation =
-        [state = m_statePtr, p = std::move(promise), f = std::move(f)]() mutable
+        [state = m_statePtr, p = std::move(promise), onReady = std::move(onReady)]() mutable
         {
+            p.resetUpstream();
+            if (p.isCancellationRequested())
+            {
+                state.reset();
+                p.setException(std::make_exception_ptr(FutureError{FutureErrorCode::cancelled}));
+                return;
+            }
             try
             {
-                Future<void> futureContinuation(std::move(state));
-                p.setValue(f(std::move(futureContinuation)));
+                onReady(state, p);
             }
             catch (...)
             {
@@ -529,25 +1494,36 @@ public:
         return future;
     }
 
-private:
-    std::shared_ptr<SharedState<void>> m_statePtr;
+    /// Links the state of the promise to this shared state while it is not done, the interrupts are resolved
+    /// only when raised and this state keeps an interrupt until its producer sets the handler.
+    /// @note The continuation attached to this state owns the link, it holds this state
+    /// and resets the link before it releases this state.
+    template <typename R>
+    void forwardInterrupts(Promise<R>& promise) const
+    {
+        if (!m_statePtr->isReady())
+        {
+            promise.setUpstream(*m_statePtr.sharedPtr());
+        }
+    }
+
+    ConsumerStatePtr<T> m_statePtr;
 };
 
-/// Explicit specialization for SharedFuture<void>
-template <>
-class SharedFuture<void>
+template <typename T>
+class SharedFuture
 {
 private:
-    friend class Future<void>;
+    friend class Future<T>;
 
-    explicit SharedFuture(std::shared_ptr<SharedState<void>> sharedStatePtr) noexcept
+    explicit SharedFuture(ConsumerStatePtr<T> sharedStatePtr) noexcept
         : m_statePtr{std::move(sharedStatePtr)}
     {}
 
 public:
     SharedFuture() = default;
 
-    explicit SharedFuture(Future<void>&& other) noexcept
+    explicit SharedFuture(Future<T>&& other) noexcept
         : SharedFuture(other.share())
     { }
 
@@ -557,7 +1533,7 @@ public:
     SharedFuture(SharedFuture&&) = default;
     SharedFuture& operator=(SharedFuture&&) = default;
 
-    void get()
+    T get()
     {
         if (!m_statePtr)
         {
@@ -566,6 +1542,17 @@ public:
         return m_statePtr->getValue();
     }
 
+    /// @brief Waits for the result and returns its copy without rethrowing the exception.
+    Try<T> getTry() const
+    {
+        if (!m_statePtr)
+        {
+            throw FutureError{FutureErrorCode::no_state};
+        }
+        m_statePtr->wait();
+        return m_statePtr->getTry();
+    }
+
     void wait() const
     {
         if (!m_statePtr)
@@ -577,84 +1564,160 @@ public:
 
     bool valid() const noexcept
     {
-        return (nullptr != m_statePtr);
+        return static_cast<bool>(m_statePtr);
+    }
+
+#if TCLIB_HAS_COROUTINES
+    /// @brief Suspends the coroutine until the shared state is ready, the shared future stays valid.
+    FutureAwaiter<T, true> operator co_await() const
+    {
+        if (!m_statePtr)
+        {
+            throw FutureError{FutureErrorCode::no_state};
+        }
+        return FutureAwaiter<T, true>(m_statePtr);
     }
+#endif
 
 private:
-    std::shared_ptr<SharedState<void>> m_statePtr;
+    ConsumerStatePtr<T> m_statePtr;
 };
 
-/// Explicit specialization for Promise<void>
-template <>
-class Promise<void>
+/// @brief Sets the values of all promises first, then passes their continuations and awaiting coroutines
+/// to the executor as one job, e.g. for a batch of responses demultiplexed by an I/O thread.
+/// @details Threads blocked in get() or wait() are woken as the values are set. The executor is called once,
+/// and only if there is a continuation to run. If a promise throws (e.g. it is already satisfied),
+/// the continuations of the promises set before are still passed to the executor and the exception is rethrown.
+/// @param range of (Promise<T>, value) pairs, e.g. std::vector<std::pair<Promise<T>, T>>, the values are moved,
+/// the value of Promise<void> is tclib::Unit, e.g. std::vector<std::pair<Promise<void>, Unit>>
+/// @param executor callable taking UniqueFunction<void()>
+template <typename Range, typename Executor>
+void fulfilAll(Range&& range, Executor&& executor)
 {
-public:
-    Promise()
-        : m_statePtr{std::make_shared<SharedState<void>>()}
-    {}
+    ContinuationBatch batch;
+    if constexpr (future_details::HasSize<Range>::value)
+    {
+        batch.reserve(std::size(range));
+    }
 
-    ~Promise()
+    auto dispatch = [&batch, &executor]()
     {
-        if (m_statePtr)
+        if (!batch.empty())
         {
-            //remove cyclic dependency between shared states,
-            //case when {Promise<int> p; auto f = p.then(...); and no call to p.setValue();
-            m_statePtr->resetContinuation();
+            executor(UniqueFunction<void()>([b = std::move(batch)]() mutable { b.run(); }));
         }
+    };
+    try
+    {
+        for (auto&& [promise, value] : range)
+        {
+            promise.setValue(std::move(value), batch);
+        }
+    }
+    catch (...)
+    {
+        dispatch();
+        throw;
     }
+    dispatch();
+}
 
-   Promise(const Promise&) = delete;
-   Promise& operator=(const Promise&) = delete;
+/// @brief Sets the values of all promises first, then runs their continuations and awaiting coroutines
+/// in the thread context of the caller.
+template <typename Range>
+void fulfilAll(Range&& range)
+{
+    fulfilAll(std::forward<Range>(range), [](UniqueFunction<void()> job){ job(); });
+}
 
-   Promise(Promise&&) = default;
-   Promise& operator=(Promise&&) = default;
+template<typename T>
+inline SharedFuture<T> Future<T>::share() noexcept
+{
+    return SharedFuture<T>(std::move(m_statePtr));
+}
 
-    void setValue()
+namespace deferred_details
+{
+    /// Passes the result of the previous stages of a deferred pipeline to the next stage.
+    template <typename Previous, typename Next>
+    struct Compose
     {
-        if (!m_statePtr)
+        template <typename T>
+        auto operator()(Future<T>&& future)
         {
-            throw FutureError{FutureErrorCode::no_state};
+            using R = decltype(m_previous(std::move(future)));
+            if constexpr (std::is_void<R>::value)
+            {
+                m_previous(std::move(future));
+                return m_next();
+            }
+            else
+            {
+                return m_next(m_previous(std::move(future)));
+            }
         }
-        m_statePtr->setValue();
-    }
 
-    Future<void> getFuture()
+        Previous m_previous;
+        Next m_next;
+    };
+}
+
+/// @brief Future with a deferred pipeline of continuations, created by Future::defer().
+/// @details The stages attached by then() are composed into a single callable without any allocation,
+/// toFuture() attaches it to the shared state of the original future as one continuation,
+/// so a pipeline of N stages costs one shared state instead of N, get() runs it on the current thread.
+/// Unlike Future::then() a stage receives the result of the previous stage (nothing for void)
+/// because there are no intermediate futures, an exception thrown by the future or a stage
+/// skips the following stages and is stored in the resulting future.
+template <typename T, typename Pipeline>
+class DeferredFuture
+{
+public:
+    explicit DeferredFuture(Future<T>&& future, Pipeline pipeline = {})
+        : m_future{std::move(future)}
+        , m_pipeline{std::move(pipeline)}
+    {}
+
+    DeferredFuture(const DeferredFuture&) = delete;
+    DeferredFuture& operator=(const DeferredFuture&) = delete;
+
+    DeferredFuture(DeferredFuture&&) = default;
+    DeferredFuture& operator=(DeferredFuture&&) = default;
+
+    /// @brief Appends the stage to the pipeline, the deferred future is invalid afterwards.
+    template <typename F>
+    auto then(F f) &&
     {
-        if (!m_statePtr)
+        if (!m_future.valid())
         {
             throw FutureError{FutureErrorCode::no_state};
         }
-        m_statePtr->setAndThrowIfRetrieved();
+        using Next = deferred_details::Compose<Pipeline, F>;
+        return DeferredFuture<T, Next>(std::move(m_future), Next{std::move(m_pipeline), std::move(f)});
+    }
 
-        return Future<void>(m_statePtr);
+    /// @brief Attaches the pipeline to the shared state as a single continuation.
+    auto toFuture() &&
+    {
+        return m_future.then(std::move(m_pipeline));
     }
 
-    void setException(std::exception_ptr exc)
+    /// @brief Waits for the future and runs the pipeline on the current thread.
+    auto get() &&
     {
-        if (!m_statePtr)
-        {
-            throw FutureError{FutureErrorCode::no_state};
-        }
-        m_statePtr->setException(exc);
+        return m_pipeline(std::move(m_future));
+    }
+
+    bool valid() const noexcept
+    {
+        return m_future.valid();
     }
 
 private:
-    std::shared_ptr<SharedState<void>> m_statePtr;
+    Future<T> m_future;
+    Pipeline m_pipeline;
 };
 
-template<typename T>
-inline SharedFuture<T> Future<T>::share() noexcept
-{
-    return SharedFuture<T>(std::move(m_statePtr));
-}
-
-//should be defined at the poin where the definition of SharedFuture is seen
-inline
-SharedFuture<void> Future<void>::share() noexcept
-{
-    return SharedFuture<void>(std::move(m_statePtr));
-}
-
 }
 
 #endif // FUTURE_HPP
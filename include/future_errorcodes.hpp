@@ -10,7 +10,8 @@ enum class FutureErrorCode
     broken_promise             = 0,
     future_already_retrieved   = 1,
     promise_already_satisfied  = 2,
-    no_state                   = 3
+    no_state                   = 3,
+    cancelled                  = 4
 };
 
 }
@@ -0,0 +1,105 @@
+#ifndef HISTOGRAM_HPP
+#define HISTOGRAM_HPP
+
+#include <array>
+#include <cstdint>
+
+namespace tclib
+{
+
+/// @brief Histogram of latencies (or any non-negative values) with logarithmic buckets.
+/// @details Like HDR histogram every power of two range is split into s_subBucketCount linear buckets,
+/// so the relative error of a recorded value is at most 1/s_subBucketCount, values below
+/// 2 * s_subBucketCount are exact. Histograms recorded by different threads are combined with merge().
+class LatencyHistogram
+{
+public:
+    static constexpr std::uint64_t s_subBucketCount = 8;
+    static constexpr std::size_t s_bucketCount = 496;
+
+    static std::size_t bucketIndex(std::uint64_t value) noexcept
+    {
+        if (value < 2 * s_subBucketCount)
+        {
+            return static_cast<std::size_t>(value);
+        }
+        const auto shift = static_cast<std::uint64_t>(highestBit(value)) - 3;
+        return static_cast<std::size_t>(s_subBucketCount * shift + (value >> shift));
+    }
+
+    static std::uint64_t bucketLowerBound(std::size_t index) noexcept
+    {
+        if (index < 2 * s_subBucketCount)
+        {
+            return index;
+        }
+        const auto shift = index / s_subBucketCount - 1;
+        return (index % s_subBucketCount + s_subBucketCount) << shift;
+    }
+
+    static std::uint64_t bucketUpperBound(std::size_t index) noexcept
+    {
+        return (index + 1 < s_bucketCount) ? bucketLowerBound(index + 1) - 1 : UINT64_MAX;
+    }
+
+    void record(std::uint64_t value, std::uint64_t count = 1) noexcept
+    {
+        m_buckets[bucketIndex(value)] += count;
+        m_count += count;
+    }
+
+    void merge(const LatencyHistogram& other) noexcept
+    {
+        for (std::size_t i = 0; i < s_bucketCount; ++i)
+        {
+            m_buckets[i] += other.m_buckets[i];
+        }
+        m_count += other.m_count;
+    }
+
+    std::uint64_t count() const noexcept
+    {
+        return m_count;
+    }
+
+    std::uint64_t bucketCount(std::size_t index) const noexcept
+    {
+        return m_buckets[index];
+    }
+
+    /// @param percentile in range [0, 100]
+    /// @return the highest value of the bucket containing the percentile, 0 for empty histogram
+    std::uint64_t valueAtPercentile(double percentile) const noexcept
+    {
+        if (0 == m_count)
+        {
+            return 0;
+        }
+        auto rank = static_cast<std::uint64_t>(percentile / 100.0 * static_cast<double>(m_count) + 0.5);
+        rank = (rank < 1) ? 1 : ((rank > m_count) ? m_count : rank);
+
+        std::uint64_t seen = 0;
+        for (std::size_t i = 0; i < s_bucketCount; ++i)
+        {
+            seen += m_buckets[i];
+            if (seen >= rank)
+            {
+                return bucketUpperBound(i);
+            }
+        }
+        return bucketUpperBound(s_bucketCount - 1);
+    }
+
+private:
+    static unsigned highestBit(std::uint64_t value) noexcept
+    {
+        return 63u - static_cast<unsigned>(__builtin_clzll(value));
+    }
+
+    std::array<std::uint64_t, s_bucketCount> m_buckets{};
+    std::uint64_t m_count = 0;
+};
+
+}
+
+#endif // HISTOGRAM_HPP
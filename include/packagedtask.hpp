@@ -0,0 +1,161 @@
+#ifndef PACKAGEDTASK_HPP
+#define PACKAGEDTASK_HPP
+
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+#include "./future.hpp"
+
+namespace tclib
+{
+
+namespace packagedtask_details
+{
+    /// Shared state of a packaged task, the callable is stored in the derived state.
+    template <typename R, typename... Arg>
+    class TaskStateBase : public SharedState<R>
+    {
+    public:
+        virtual ~TaskStateBase() = default;
+
+        virtual void run(Promise<R>& promise, Arg&&... arg) = 0;
+    };
+
+    /// The callable embedded in the shared state, so both are allocated at once.
+    /// The callable is destroyed after the call, releasing its captures before the result is published.
+    template <typename F, typename R, typename... Arg>
+    class TaskState final : public TaskStateBase<R, Arg...>
+    {
+    public:
+        template <typename C>
+        explicit TaskState(C&& callable)
+            : m_callable{std::in_place, std::forward<C>(callable)}
+        {}
+
+        /// The result is stored as returned by the callable, a returned future is not unwrapped,
+        /// like by std::packaged_task.
+        void run(Promise<R>& promise, Arg&&... arg) override
+        {
+            if (!m_callable)
+            {
+                throw FutureError{FutureErrorCode::promise_already_satisfied};
+            }
+            std::optional<future_details::ValueT<R>> result;
+            std::exception_ptr exc;
+            try
+            {
+                if constexpr (std::is_void<R>::value)
+                {
+                    (*m_callable)(std::forward<Arg>(arg)...);
+                    result.emplace();
+                }
+                else
+                {
+                    result.emplace((*m_callable)(std::forward<Arg>(arg)...));
+                }
+            }
+            catch (...)
+            {
+                exc = std::current_exception();
+            }
+            m_callable.reset();
+
+            if (exc)
+            {
+                promise.setException(std::move(exc));
+            }
+            else
+            {
+                promise.setValue(std::move(result.value()));
+            }
+        }
+
+    private:
+        std::optional<F> m_callable;
+    };
+}
+
+/// @brief Callable wrapper that stores the result of the call in the shared state of a future,
+/// like std::packaged_task.
+/// @details The callable is embedded in the shared state, the task costs a single allocation.
+/// PackagedTask<R()> fits the small buffer of UniqueFunction<void()>, so it is moved
+/// into an executor queue without additional allocation.
+/// The future gets broken_promise error if the task is destroyed without being called.
+template <typename R, typename... Arg>
+class PackagedTask<R(Arg...)>
+{
+private:
+    using StateBase = packagedtask_details::TaskStateBase<R, Arg...>;
+
+public:
+    PackagedTask() noexcept
+        : m_task{nullptr}
+        , m_promise{std::shared_ptr<SharedState<R>>()}
+    {}
+
+    template <typename F, typename C = std::decay_t<F>,
+              typename = typename std::enable_if_t<!(std::is_same<C, PackagedTask>::value)>>
+    explicit PackagedTask(F&& callable)
+        : PackagedTask(std::shared_ptr<StateBase>(
+                           std::make_shared<packagedtask_details::TaskState<C, R, Arg...>>(std::forward<F>(callable))))
+    {}
+
+    PackagedTask(const PackagedTask&) = delete;
+    PackagedTask& operator=(const PackagedTask&) = delete;
+
+    PackagedTask(PackagedTask&& other) noexcept
+        : m_task{std::exchange(other.m_task, nullptr)}
+        , m_promise{std::move(other.m_promise)}
+    {}
+
+    PackagedTask& operator=(PackagedTask&& other)
+    {
+        if (this != std::addressof(other))
+        {
+            //the promise of the replaced task is broken
+            m_promise = std::move(other.m_promise);
+            m_task = std::exchange(other.m_task, nullptr);
+        }
+        return *this;
+    }
+
+    bool valid() const noexcept
+    {
+        return (nullptr != m_task);
+    }
+
+    Future<R> getFuture()
+    {
+        if (!m_task)
+        {
+            throw FutureError{FutureErrorCode::no_state};
+        }
+        return m_promise.getFuture();
+    }
+
+    /// @brief Calls the callable and stores its result or exception in the shared state.
+    void operator()(Arg... arg)
+    {
+        if (!m_task)
+        {
+            throw FutureError{FutureErrorCode::no_state};
+        }
+        m_task->run(m_promise, std::forward<Arg>(arg)...);
+    }
+
+private:
+    explicit PackagedTask(std::shared_ptr<StateBase> statePtr) noexcept
+        : m_task{statePtr.get()}
+        , m_promise{std::move(statePtr)}
+    {}
+
+    //points to the state owned by the promise
+    StateBase* m_task;
+    Promise<R> m_promise;
+};
+
+}
+
+#endif // PACKAGEDTASK_HPP
@@ -0,0 +1,234 @@
+#ifndef PROMISEARRAY_HPP
+#define PROMISEARRAY_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "./future.hpp"
+
+namespace tclib
+{
+
+namespace promisearray_details
+{
+    /// Every state of the block starts on its own cache line,
+    /// so the producers and consumers of adjacent states do not contend on the same line.
+    template <typename T>
+    struct alignas(s_cacheLineSize) Slot
+    {
+        SharedState<T> m_state;
+    };
+
+    template <typename T>
+    using WhenAllResult = std::conditional_t<std::is_void<T>::value, void, std::vector<T>>;
+
+    /// Shared by the continuations of all states of the array, the last one completes the promise.
+    template <typename T>
+    struct WhenAllState
+    {
+        explicit WhenAllState(std::vector<Future<T>> futures)
+            : m_futures{std::move(futures)}
+            , m_remaining{m_futures.size()}
+        {}
+
+        void onReady()
+        {
+            if (1 != m_remaining.fetch_sub(1, std::memory_order_acq_rel))
+            {
+                return;
+            }
+            //the exception of the lowest index wins, so the result does not depend on the completion order
+            if constexpr (std::is_void<T>::value)
+            {
+                for (auto& future : m_futures)
+                {
+                    if (auto exc = future.getTry().exception())
+                    {
+                        m_promise.setException(std::move(exc));
+                        return;
+                    }
+                }
+                m_promise.setValue();
+            }
+            else
+            {
+                std::vector<T> values;
+                values.reserve(m_futures.size());
+                for (auto& future : m_futures)
+                {
+                    auto result = future.getTry();
+                    if (result.hasException())
+                    {
+                        m_promise.setException(result.exception());
+                        return;
+                    }
+                    values.push_back(std::move(result).value());
+                }
+                m_promise.setValue(std::move(values));
+            }
+        }
+
+        std::vector<Future<T>> m_futures;
+        std::atomic<std::size_t> m_remaining;
+        Promise<WhenAllResult<T>> m_promise;
+    };
+}
+
+/// @brief Futures of the shared states allocated together by PromiseArray.
+template <typename T>
+class FutureArray
+{
+private:
+    friend class PromiseArray<T>;
+
+    explicit FutureArray(std::vector<Future<T>> futures) noexcept
+        : m_futures{std::move(futures)}
+    {}
+
+public:
+    using iterator = typename std::vector<Future<T>>::iterator;
+
+    FutureArray() = default;
+
+    FutureArray(const FutureArray&) = delete;
+    FutureArray& operator=(const FutureArray&) = delete;
+
+    FutureArray(FutureArray&&) = default;
+    FutureArray& operator=(FutureArray&&) = default;
+
+    std::size_t size() const noexcept
+    {
+        return m_futures.size();
+    }
+
+    Future<T>& operator[](std::size_t index) noexcept
+    {
+        return m_futures[index];
+    }
+
+    iterator begin() noexcept
+    {
+        return m_futures.begin();
+    }
+
+    iterator end() noexcept
+    {
+        return m_futures.end();
+    }
+
+    /// @brief Returns the future of all values in index order (Future<void> for void states),
+    /// the array is empty afterwards.
+    /// @details If any state holds an exception, the future holds the exception of the lowest index.
+    /// The continuations attached to the states share one object, they fit the small buffer
+    /// of UniqueFunction and are attached without allocation. The last state set completes the future
+    /// in its thread context.
+    Future<promisearray_details::WhenAllResult<T>> whenAll() &&
+    {
+        for (auto& future : m_futures)
+        {
+            if (!future.m_statePtr)
+            {
+                throw FutureError{FutureErrorCode::no_state};
+            }
+        }
+
+        auto whenAllState = std::make_shared<promisearray_details::WhenAllState<T>>(std::move(m_futures));
+        auto future = whenAllState->m_promise.getFuture();
+        if (whenAllState->m_futures.empty())
+        {
+            if constexpr (std::is_void<T>::value)
+            {
+                whenAllState->m_promise.setValue();
+            }
+            else
+            {
+                whenAllState->m_promise.setValue({});
+            }
+            return future;
+        }
+        //the futures are kept in the shared object, so the states stay consumed until all are ready
+        for (auto& stateFuture : whenAllState->m_futures)
+        {
+            stateFuture.m_statePtr->setContinuation([whenAllState]() { whenAllState->onReady(); });
+        }
+        return future;
+    }
+
+private:
+    std::vector<Future<T>> m_futures;
+};
+
+/// @brief Array of promises whose shared states are allocated at once, for scatter/gather code.
+/// @details The states are stored contiguously in one block, each aligned to a cache line,
+/// and share the reference count of the block, so N states cost three allocations instead of N:
+/// the block, its control block and the vector of promises. The block is released when the last
+/// promise, future or continuation referring to any of its states is gone.
+template <typename T>
+class PromiseArray
+{
+public:
+    using iterator = typename std::vector<Promise<T>>::iterator;
+
+    PromiseArray() = default;
+
+    explicit PromiseArray(std::size_t size)
+    {
+        //the states are not copyable, std::make_shared of an array requires copyable elements in libstdc++
+        std::shared_ptr<promisearray_details::Slot<T>[]> block(new promisearray_details::Slot<T>[size]);
+        m_promises.reserve(size);
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            m_promises.push_back(Promise<T>(std::shared_ptr<SharedState<T>>(block, &block[i].m_state)));
+        }
+    }
+
+    PromiseArray(const PromiseArray&) = delete;
+    PromiseArray& operator=(const PromiseArray&) = delete;
+
+    PromiseArray(PromiseArray&&) = default;
+    PromiseArray& operator=(PromiseArray&&) = default;
+
+    std::size_t size() const noexcept
+    {
+        return m_promises.size();
+    }
+
+    /// @note the promise can be moved out, e.g. to the worker producing its value
+    Promise<T>& operator[](std::size_t index) noexcept
+    {
+        return m_promises[index];
+    }
+
+    iterator begin() noexcept
+    {
+        return m_promises.begin();
+    }
+
+    iterator end() noexcept
+    {
+        return m_promises.end();
+    }
+
+    /// @brief Retrieves the futures of all states, can be called once and before the promises are moved out.
+    FutureArray<T> getFutures()
+    {
+        std::vector<Future<T>> futures;
+        futures.reserve(m_promises.size());
+        for (auto& promise : m_promises)
+        {
+            futures.push_back(promise.getFuture());
+        }
+        return FutureArray<T>(std::move(futures));
+    }
+
+private:
+    std::vector<Promise<T>> m_promises;
+};
+
+}
+
+#endif // PROMISEARRAY_HPP
@@ -0,0 +1,304 @@
+#ifndef STATS_HPP
+#define STATS_HPP
+
+#include <cstdint>
+
+#include "./histogram.hpp"
+
+//latency histograms are collected together with the other counters
+#if defined(TCLIB_ENABLE_LATENCY_STATS) && !defined(TCLIB_ENABLE_STATS)
+#define TCLIB_ENABLE_STATS
+#endif
+
+#ifdef TCLIB_ENABLE_STATS
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <vector>
+#include <algorithm>
+#endif
+
+namespace tclib
+{
+
+/// @brief Snapshot of the library counters, aggregated over all threads.
+/// @details The counters are collected only if the library is compiled with TCLIB_ENABLE_STATS,
+/// otherwise the snapshot is always zero and collecting them costs nothing.
+struct Stats
+{
+    std::uint64_t statesConstructed = 0;
+    std::uint64_t statesDestructed = 0;
+    std::uint64_t continuationsAttached = 0;
+    std::uint64_t continuationsRunInline = 0;
+    std::uint64_t blockingWaitsStarted = 0;
+    std::uint64_t blockingWaits = 0;
+    std::uint64_t blockedNanoseconds = 0;
+    std::uint64_t uniqueFunctionHeapAllocations = 0;
+    std::uint64_t exceptionsPropagated = 0;
+
+    std::uint64_t liveStates() const noexcept
+    {
+        return statesConstructed - statesDestructed;
+    }
+
+    /// threads currently blocked waiting for a shared state
+    std::uint64_t blockedWaiters() const noexcept
+    {
+        return blockingWaitsStarted - blockingWaits;
+    }
+};
+
+/// @brief Snapshot of the promise-to-consumer handoff latencies in nanoseconds, aggregated over all threads.
+/// @details The latencies are measured only if the library is compiled with TCLIB_ENABLE_LATENCY_STATS,
+/// then every shared state takes a timestamp when its value or exception is set.
+struct LatencyStats
+{
+    /// from setValue/setException to the moment a blocked waiter wakes up
+    LatencyHistogram setToWake;
+    /// from setValue/setException to the moment a continuation (or awaiting coroutine) starts
+    LatencyHistogram setToContinuationStart;
+};
+
+#ifdef TCLIB_ENABLE_STATS
+
+namespace stats_details
+{
+    enum Counter : std::size_t
+    {
+        statesConstructed,
+        statesDestructed,
+        continuationsAttached,
+        continuationsRunInline,
+        blockingWaitsStarted,
+        blockingWaits,
+        blockedNanoseconds,
+        uniqueFunctionHeapAllocations,
+        exceptionsPropagated,
+        counterCount
+    };
+
+    using Values = std::array<std::uint64_t, counterCount>;
+
+    inline void addRelaxed(std::atomic<std::uint64_t>& v, std::uint64_t value) noexcept
+    {
+        v.store(v.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+#ifdef TCLIB_ENABLE_LATENCY_STATS
+    enum Latency : std::size_t
+    {
+        setToWake,
+        setToContinuationStart,
+        latencyCount
+    };
+
+    using Buckets = std::array<std::atomic<std::uint64_t>, LatencyHistogram::s_bucketCount>;
+
+    inline void mergeBuckets(LatencyHistogram& histogram, const Buckets& buckets) noexcept
+    {
+        for (std::size_t i = 0; i < LatencyHistogram::s_bucketCount; ++i)
+        {
+            const auto count = buckets[i].load(std::memory_order_relaxed);
+            if (0 != count)
+            {
+                histogram.record(LatencyHistogram::bucketLowerBound(i), count);
+            }
+        }
+    }
+#endif
+
+    /// Counters written only by the owner thread, read by any thread.
+    struct ThreadCounters
+    {
+        std::array<std::atomic<std::uint64_t>, counterCount> m_values{};
+#ifdef TCLIB_ENABLE_LATENCY_STATS
+        std::array<Buckets, latencyCount> m_latencies{};
+#endif
+
+        void add(Counter counter, std::uint64_t value) noexcept
+        {
+            addRelaxed(m_values[counter], value);
+        }
+
+#ifdef TCLIB_ENABLE_LATENCY_STATS
+        void record(Latency latency, std::uint64_t nanoseconds) noexcept
+        {
+            addRelaxed(m_latencies[latency][LatencyHistogram::bucketIndex(nanoseconds)], 1);
+        }
+#endif
+    };
+
+    class Registry
+    {
+    public:
+        void add(ThreadCounters* counters)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_threads.push_back(counters);
+        }
+
+        /// counters of the exited thread are kept in the retired values
+        void remove(ThreadCounters* counters)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (std::size_t i = 0; i < counterCount; ++i)
+            {
+                m_retired[i] += counters->m_values[i].load(std::memory_order_relaxed);
+            }
+#ifdef TCLIB_ENABLE_LATENCY_STATS
+            mergeBuckets(m_retiredLatencies.setToWake, counters->m_latencies[Latency::setToWake]);
+            mergeBuckets(m_retiredLatencies.setToContinuationStart,
+                         counters->m_latencies[Latency::setToContinuationStart]);
+#endif
+            m_threads.erase(std::remove(m_threads.begin(), m_threads.end(), counters), m_threads.end());
+        }
+
+        Values snapshot() const
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto values = m_retired;
+            for (auto counters : m_threads)
+            {
+                for (std::size_t i = 0; i < counterCount; ++i)
+                {
+                    values[i] += counters->m_values[i].load(std::memory_order_relaxed);
+                }
+            }
+            return values;
+        }
+
+#ifdef TCLIB_ENABLE_LATENCY_STATS
+        LatencyStats latencySnapshot() const
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto latencies = m_retiredLatencies;
+            for (auto counters : m_threads)
+            {
+                mergeBuckets(latencies.setToWake, counters->m_latencies[Latency::setToWake]);
+                mergeBuckets(latencies.setToContinuationStart, counters->m_latencies[Latency::setToContinuationStart]);
+            }
+            return latencies;
+        }
+#endif
+
+    private:
+        mutable std::mutex m_mutex;
+        std::vector<ThreadCounters*> m_threads;
+        Values m_retired{};
+#ifdef TCLIB_ENABLE_LATENCY_STATS
+        LatencyStats m_retiredLatencies;
+#endif
+    };
+
+    inline Registry& registry()
+    {
+        static Registry s_registry;
+        return s_registry;
+    }
+
+    class ThreadCountersHolder
+    {
+    public:
+        ThreadCountersHolder()
+        {
+            registry().add(&m_counters);
+        }
+
+        ~ThreadCountersHolder()
+        {
+            registry().remove(&m_counters);
+        }
+
+        ThreadCountersHolder(const ThreadCountersHolder&) = delete;
+        ThreadCountersHolder& operator=(const ThreadCountersHolder&) = delete;
+
+        ThreadCounters& counters() noexcept
+        {
+            return m_counters;
+        }
+
+    private:
+        ThreadCounters m_counters;
+    };
+
+    inline ThreadCounters& threadCounters()
+    {
+        thread_local ThreadCountersHolder s_holder;
+        return s_holder.counters();
+    }
+
+    inline void add(Counter counter, std::uint64_t value)
+    {
+        threadCounters().add(counter, value);
+    }
+
+    inline std::chrono::steady_clock::time_point now() noexcept
+    {
+        return std::chrono::steady_clock::now();
+    }
+
+    inline std::uint64_t nanosecondsSince(std::chrono::steady_clock::time_point start) noexcept
+    {
+        return static_cast<std::uint64_t>(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(now() - start).count());
+    }
+}
+
+inline Stats getStats()
+{
+    using namespace stats_details;
+    const auto values = registry().snapshot();
+
+    Stats stats;
+    stats.statesConstructed = values[Counter::statesConstructed];
+    stats.statesDestructed = values[Counter::statesDestructed];
+    stats.continuationsAttached = values[Counter::continuationsAttached];
+    stats.continuationsRunInline = values[Counter::continuationsRunInline];
+    stats.blockingWaitsStarted = values[Counter::blockingWaitsStarted];
+    stats.blockingWaits = values[Counter::blockingWaits];
+    stats.blockedNanoseconds = values[Counter::blockedNanoseconds];
+    stats.uniqueFunctionHeapAllocations = values[Counter::uniqueFunctionHeapAllocations];
+    stats.exceptionsPropagated = values[Counter::exceptionsPropagated];
+    return stats;
+}
+
+#define TCLIB_STATS_ADD(counter, value) \
+    ::tclib::stats_details::add(::tclib::stats_details::Counter::counter, (value))
+
+#else
+
+inline Stats getStats() noexcept
+{
+    return {};
+}
+
+#define TCLIB_STATS_ADD(counter, value) ((void)0)
+
+#endif // TCLIB_ENABLE_STATS
+
+#ifdef TCLIB_ENABLE_LATENCY_STATS
+
+inline LatencyStats getLatencyStats()
+{
+    return stats_details::registry().latencySnapshot();
+}
+
+#define TCLIB_LATENCY_RECORD(latency, start) \
+    ::tclib::stats_details::threadCounters().record(::tclib::stats_details::Latency::latency, \
+                                                    ::tclib::stats_details::nanosecondsSince(start))
+
+#else
+
+inline LatencyStats getLatencyStats()
+{
+    return {};
+}
+
+#define TCLIB_LATENCY_RECORD(latency, start) ((void)0)
+
+#endif // TCLIB_ENABLE_LATENCY_STATS
+
+}
+
+#endif // STATS_HPP
@@ -0,0 +1,441 @@
+#ifndef STREAM_HPP
+#define STREAM_HPP
+
+#include <mutex>
+#include <condition_variable>
+#include <optional>
+#include <vector>
+#include <algorithm>
+
+#include <stdexcept>
+#include <memory>
+#include <atomic>
+
+#include "./future.hpp"
+
+namespace tclib
+{
+
+/// @brief Bounded buffer of values shared between StreamPromise (producer) and Stream (consumer).
+/// @details The buffer is a ring of slots allocated once and reused for all values of the stream.
+/// The producer is blocked (or its coroutine is suspended) while the buffer is full,
+/// the consumer is blocked (or its coroutine is suspended) while the buffer is empty.
+/// @note The stream does not reuse Promise and SharedState. A shared state is set once and cannot be
+/// rearmed, so a Promise/Future pair per value would allocate a state per value, and a shared state has
+/// no way to block its producer, which the bounded buffer needs. The stream follows their conventions instead:
+/// FutureError codes, broken_promise for a producer destroyed without closing the stream and
+/// future_already_retrieved for a second consumer.
+/// The suspended coroutines are kept as coroutine_details::CoroutineRef and resumed by the same code in every build,
+/// so the state has the same definition in C++17 and C++20 translation units, only the awaiters require C++20.
+template <typename T>
+class StreamState
+{
+public:
+    explicit StreamState(std::size_t capacity)
+        : m_buffer(std::max<std::size_t>(capacity, 1))
+    {}
+
+    StreamState(const StreamState&) = delete;
+    StreamState& operator=(const StreamState&) = delete;
+
+    /// @return false if the consumer is gone and the value is dropped
+    bool push(T value)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        checkState();
+        m_notFull.wait(lock, [this](){ return !isFull() || m_abandoned; });
+        return pushAndNotify(lock, std::move(value));
+    }
+
+    void close()
+    {
+        closeAndNotify(nullptr);
+    }
+
+    void setException(std::exception_ptr exc)
+    {
+        closeAndNotify(std::move(exc));
+    }
+
+    /// @return the next value or empty optional if the stream is closed and all values are consumed
+    std::optional<T> pop()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_notEmpty.wait(lock, [this](){ return (0 != m_size) || m_closed; });
+        return popAndNotify(lock);
+    }
+
+    void abandon()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_abandoned = true;
+        }
+        m_notFull.notify_all();
+        resume(takeProducer());
+    }
+
+    void setAndThrowIfRetrieved()
+    {
+        if (m_retrieved.test_and_set())
+        {
+            throw FutureError{FutureErrorCode::future_already_retrieved};
+        }
+    }
+
+    bool isClosed() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_closed;
+    }
+
+    /// @return false if the value is pushed and the producer coroutine should not be suspended
+    bool suspendProducerOrPush(coroutine_details::CoroutineRef producer, std::optional<T>& value, bool& pushed)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        checkState();
+        if (isFull() && !m_abandoned)
+        {
+            m_producer = producer;
+            return true;
+        }
+        pushed = pushAndNotify(lock, std::move(*value));
+        value.reset();
+        return false;
+    }
+
+    bool pushAfterResume(T value)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        return pushAndNotify(lock, std::move(value));
+    }
+
+    /// @return false if a value is available or the stream is closed and the consumer should not be suspended
+    bool suspendConsumer(coroutine_details::CoroutineRef consumer)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if ((0 != m_size) || m_closed)
+        {
+            return false;
+        }
+        m_consumer = consumer;
+        return true;
+    }
+
+    std::optional<T> popAfterResume()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        return popAndNotify(lock);
+    }
+
+private:
+    void checkState() const
+    {
+        if (m_closed)
+        {
+            throw FutureError{FutureErrorCode::promise_already_satisfied};
+        }
+    }
+
+    bool isFull() const noexcept
+    {
+        return m_size == m_buffer.size();
+    }
+
+    bool pushAndNotify(std::unique_lock<std::mutex>& lock, T value)
+    {
+        if (m_abandoned)
+        {
+            return false;
+        }
+        m_buffer[(m_head + m_size) % m_buffer.size()].emplace(std::move(value));
+        ++m_size;
+        auto consumer = std::exchange(m_consumer, {});
+        lock.unlock();
+        m_notEmpty.notify_one();
+        resume(consumer);
+        return true;
+    }
+
+    std::optional<T> popAndNotify(std::unique_lock<std::mutex>& lock)
+    {
+        if (0 == m_size)
+        {
+            if (m_exception)
+            {
+                std::rethrow_exception(m_exception);
+            }
+            return std::nullopt;
+        }
+        auto& slot = m_buffer[m_head];
+        std::optional<T> value{std::move(slot)};
+        slot.reset();
+        m_head = (m_head + 1) % m_buffer.size();
+        --m_size;
+        auto producer = std::exchange(m_producer, {});
+        lock.unlock();
+        m_notFull.notify_one();
+        resume(producer);
+        return value;
+    }
+
+    void closeAndNotify(std::exception_ptr exc)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            checkState();
+            m_closed = true;
+            m_exception = std::move(exc);
+        }
+        m_notEmpty.notify_all();
+        resume(takeConsumer());
+    }
+
+    coroutine_details::CoroutineRef takeProducer()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return std::exchange(m_producer, {});
+    }
+
+    coroutine_details::CoroutineRef takeConsumer()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return std::exchange(m_consumer, {});
+    }
+
+    static void resume(coroutine_details::CoroutineRef coroutine)
+    {
+        if (coroutine)
+        {
+            coroutine();
+        }
+    }
+
+private:
+    std::vector<std::optional<T>> m_buffer;
+    std::size_t m_head = 0;
+    std::size_t m_size = 0;
+    bool m_closed = false;
+    bool m_abandoned = false;
+    std::atomic_flag m_retrieved = ATOMIC_FLAG_INIT;
+    std::exception_ptr m_exception;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_notEmpty;
+    std::condition_variable m_notFull;
+    coroutine_details::CoroutineRef m_producer;
+    coroutine_details::CoroutineRef m_consumer;
+};
+
+template <typename T> class Stream;
+
+/// @brief Producer side of a stream of values, delivers values one at a time to the Stream consumer.
+/// @details At most capacity values are buffered, push blocks (co_await write suspends)
+/// while the consumer lags behind. The stream ends with close() or setException(),
+/// a producer destroyed without closing the stream ends it with broken_promise error.
+template <typename T>
+class StreamPromise
+{
+public:
+    explicit StreamPromise(std::size_t capacity = 1)
+        : m_statePtr{std::make_shared<StreamState<T>>(capacity)}
+    {}
+
+    ~StreamPromise()
+    {
+        if (m_statePtr && !m_statePtr->isClosed())
+        {
+            m_statePtr->setException(std::make_exception_ptr(FutureError{FutureErrorCode::broken_promise}));
+        }
+    }
+
+    StreamPromise(const StreamPromise&) = delete;
+    StreamPromise& operator=(const StreamPromise&) = delete;
+
+    StreamPromise(StreamPromise&&) = default;
+    StreamPromise& operator=(StreamPromise&& other)
+    {
+        if (this != std::addressof(other))
+        {
+            //the stream of this promise is ended by the destructor of the temporary
+            StreamPromise tmp(std::move(*this));
+            m_statePtr = std::move(other.m_statePtr);
+        }
+        return *this;
+    }
+
+    Stream<T> getStream()
+    {
+        if (!m_statePtr)
+        {
+            throw FutureError{FutureErrorCode::no_state};
+        }
+        m_statePtr->setAndThrowIfRetrieved();
+
+        return Stream<T>(m_statePtr);
+    }
+
+    /// @brief Pushes the value, blocks the current thread while the buffer is full.
+    /// @return false if the consumer is gone and the producer can stop
+    bool push(T value)
+    {
+        if (!m_statePtr)
+        {
+            throw FutureError{FutureErrorCode::no_state};
+        }
+        return m_statePtr->push(std::move(value));
+    }
+
+#if TCLIB_HAS_COROUTINES
+    /// @brief Pushes the value, suspends the coroutine while the buffer is full.
+    /// @return awaiter of bool, false if the consumer is gone and the producer can stop
+    auto write(T value)
+    {
+        if (!m_statePtr)
+        {
+            throw FutureError{FutureErrorCode::no_state};
+        }
+
+        struct Awaiter
+        {
+            bool await_ready() const noexcept
+            {
+                return false;
+            }
+
+            bool await_suspend(std::coroutine_handle<> handle)
+            {
+                return m_state.suspendProducerOrPush(coroutine_details::makeCoroutineRef(handle), m_value, m_pushed);
+            }
+
+            bool await_resume()
+            {
+                if (m_value)
+                {
+                    m_pushed = m_state.pushAfterResume(std::move(*m_value));
+                }
+                return m_pushed;
+            }
+
+            StreamState<T>& m_state;
+            std::optional<T> m_value;
+            bool m_pushed = false;
+        };
+        return Awaiter{*m_statePtr, std::move(value)};
+    }
+#endif
+
+    void close()
+    {
+        if (!m_statePtr)
+        {
+            throw FutureError{FutureErrorCode::no_state};
+        }
+        m_statePtr->close();
+    }
+
+    void setException(std::exception_ptr exc)
+    {
+        if (!m_statePtr)
+        {
+            throw FutureError{FutureErrorCode::no_state};
+        }
+        m_statePtr->setException(exc);
+    }
+
+private:
+    std::shared_ptr<StreamState<T>> m_statePtr;
+};
+
+/// @brief Consumer side of a stream of values.
+template <typename T>
+class Stream
+{
+private:
+    friend class StreamPromise<T>;
+
+    explicit Stream(std::shared_ptr<StreamState<T>> sharedStatePtr) noexcept
+        : m_statePtr{std::move(sharedStatePtr)}
+    {}
+
+public:
+    Stream() = default;
+
+    ~Stream()
+    {
+        if (m_statePtr)
+        {
+            //unblock the producer, the values pushed afterwards are dropped
+            m_statePtr->abandon();
+        }
+    }
+
+    Stream(const Stream&) = delete;
+    Stream& operator=(const Stream&) = delete;
+
+    Stream(Stream&&) = default;
+    Stream& operator=(Stream&& other)
+    {
+        if (this != std::addressof(other))
+        {
+            Stream tmp(std::move(*this));
+            m_statePtr = std::move(other.m_statePtr);
+        }
+        return *this;
+    }
+
+    /// @brief Returns the next value, blocks the current thread while the buffer is empty.
+    /// @return empty optional when the stream is closed and all values are consumed
+    std::optional<T> get()
+    {
+        if (!m_statePtr)
+        {
+            throw FutureError{FutureErrorCode::no_state};
+        }
+        return m_statePtr->pop();
+    }
+
+#if TCLIB_HAS_COROUTINES
+    /// @brief Suspends the coroutine while the buffer is empty.
+    /// @return awaiter of the next value, empty optional when the stream is closed and all values are consumed
+    auto next()
+    {
+        if (!m_statePtr)
+        {
+            throw FutureError{FutureErrorCode::no_state};
+        }
+
+        struct Awaiter
+        {
+            bool await_ready() const noexcept
+            {
+                return false;
+            }
+
+            bool await_suspend(std::coroutine_handle<> handle)
+            {
+                return m_state.suspendConsumer(coroutine_details::makeCoroutineRef(handle));
+            }
+
+            std::optional<T> await_resume()
+            {
+                return m_state.popAfterResume();
+            }
+
+            StreamState<T>& m_state;
+        };
+        return Awaiter{*m_statePtr};
+    }
+#endif
+
+    bool valid() const noexcept
+    {
+        return (nullptr != m_statePtr);
+    }
+
+private:
+    std::shared_ptr<StreamState<T>> m_statePtr;
+};
+
+}
+
+#endif // STREAM_HPP
@@ -0,0 +1,296 @@
+#ifndef TASK_HPP
+#define TASK_HPP
+
+#include "./future.hpp"
+
+#if TCLIB_HAS_COROUTINES
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+
+namespace tclib
+{
+
+template <typename T> class Task;
+
+namespace task_details
+{
+    /// Resumes the awaiting coroutine on the trampoline of the current thread,
+    /// or publishes the result to the future of a detached task and destroys the coroutine frame.
+    struct FinalAwaiter
+    {
+        bool await_ready() const noexcept
+        {
+            return false;
+        }
+
+        //Note: the awaiting coroutine can destroy this frame when it is resumed, nothing is accessed afterwards
+        template <typename P>
+        void await_suspend(std::coroutine_handle<P> handle) noexcept
+        {
+            auto& promise = handle.promise();
+            if (auto continuation = promise.m_continuation)
+            {
+                trampoline_details::run(continuation);
+                return;
+            }
+            if (promise.m_detached)
+            {
+                promise.publish(handle);
+            }
+        }
+
+        void await_resume() const noexcept {}
+    };
+
+    class TaskPromiseBase
+    {
+    public:
+        std::suspend_always initial_suspend() const noexcept
+        {
+            return {};
+        }
+
+        FinalAwaiter final_suspend() const noexcept
+        {
+            return {};
+        }
+
+        void unhandled_exception() noexcept
+        {
+            m_exception = std::current_exception();
+        }
+
+    protected:
+        friend struct FinalAwaiter;
+        template <typename T> friend class tclib::Task;
+
+        std::coroutine_handle<> m_continuation;
+        std::exception_ptr m_exception;
+        bool m_detached = false;
+    };
+
+    /// The result is stored in the coroutine frame, not in a shared state, so an awaited task costs
+    /// only the frame allocation. It is moved to the shared state of the future only if the task is converted to a future.
+    template <typename T>
+    class TaskPromise : public TaskPromiseBase
+    {
+    public:
+        Task<T> get_return_object() noexcept;
+
+        template <typename U>
+        void return_value(U&& value)
+        {
+            m_result.emplace(std::forward<U>(value));
+        }
+
+        T getResult()
+        {
+            if (m_exception)
+            {
+                std::rethrow_exception(m_exception);
+            }
+            return std::move(m_result.value());
+        }
+
+    private:
+        friend struct FinalAwaiter;
+        friend class Task<T>;
+
+        void publish(std::coroutine_handle<TaskPromise> handle) noexcept
+        {
+            auto promise = std::move(m_promise.value());
+            auto exception = std::move(m_exception);
+            auto result = std::move(m_result);
+            handle.destroy();
+
+            if (exception)
+            {
+                promise.setException(std::move(exception));
+            }
+            else
+            {
+                promise.setValue(std::move(result.value()));
+            }
+        }
+
+        std::optional<T> m_result;
+        //the shared state is allocated only if the task is converted to a future
+        std::optional<Promise<T>> m_promise;
+    };
+
+    /// Explicit specialization for TaskPromise<void>
+    template <>
+    class TaskPromise<void> : public TaskPromiseBase
+    {
+    public:
+        Task<void> get_return_object() noexcept;
+
+        void return_void() const noexcept {}
+
+        void getResult()
+        {
+            if (m_exception)
+            {
+                std::rethrow_exception(m_exception);
+            }
+        }
+
+    private:
+        friend struct FinalAwaiter;
+        friend class Task<void>;
+
+        void publish(std::coroutine_handle<TaskPromise> handle) noexcept
+        {
+            auto promise = std::move(m_promise.value());
+            auto exception = std::move(m_exception);
+            handle.destroy();
+
+            if (exception)
+            {
+                promise.setException(std::move(exception));
+            }
+            else
+            {
+                promise.setValue();
+            }
+        }
+
+        //the shared state is allocated only if the task is converted to a future
+        std::optional<Promise<void>> m_promise;
+    };
+}
+
+/// @brief Lazily started coroutine returning a value of type T.
+/// @details The coroutine is started when the task is awaited or converted to a future.
+/// The awaited task is started and the awaiting coroutine is resumed on the trampoline of the current thread
+/// (see trampoline_details::Trampoline), so a long or deeply nested chain of co_await does not grow the stack
+/// beyond the inline depth of the trampoline, regardless of the optimization level.
+template <typename T>
+class Task
+{
+public:
+    using promise_type = task_details::TaskPromise<T>;
+
+    Task() = default;
+
+    ~Task()
+    {
+        if (m_handle)
+        {
+            m_handle.destroy();
+        }
+    }
+
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+    Task(Task&& other) noexcept
+        : m_handle{std::exchange(other.m_handle, nullptr)}
+    {}
+
+    Task& operator=(Task&& other) noexcept
+    {
+        if (this != std::addressof(other))
+        {
+            if (m_handle)
+            {
+                m_handle.destroy();
+            }
+            m_handle = std::exchange(other.m_handle, nullptr);
+        }
+        return *this;
+    }
+
+    bool valid() const noexcept
+    {
+        return static_cast<bool>(m_handle);
+    }
+
+    /// @brief Starts the task and returns the future of its result, the task is invalid afterwards.
+    /// @details The coroutine frame publishes its result directly to the shared state of the future
+    /// and destroys itself, no continuation or intermediate promise is created.
+    /// @note The shared state is allocated in addition to the coroutine frame, the future owns it
+    /// by a shared pointer and the frame is released as soon as the result is published.
+    Future<T> toFuture() &&
+    {
+        if (!m_handle)
+        {
+            throw FutureError{FutureErrorCode::no_state};
+        }
+        auto& promise = m_handle.promise();
+        auto future = promise.m_promise.emplace().getFuture();
+        promise.m_detached = true;
+        std::exchange(m_handle, nullptr).resume();
+        return future;
+    }
+
+    auto operator co_await() && noexcept
+    {
+        struct Awaiter
+        {
+            bool await_ready() const noexcept
+            {
+                return !m_handle || m_handle.done();
+            }
+
+            //Note: the awaiting coroutine can be resumed and this awaiter destroyed before run() returns
+            void await_suspend(std::coroutine_handle<> continuation)
+            {
+                const auto handle = m_handle;
+                handle.promise().m_continuation = continuation;
+                trampoline_details::run(handle);
+            }
+
+            T await_resume()
+            {
+                if (!m_handle)
+                {
+                    throw FutureError{FutureErrorCode::no_state};
+                }
+                return m_handle.promise().getResult();
+            }
+
+            std::coroutine_handle<promise_type> m_handle;
+        };
+        return Awaiter{m_handle};
+    }
+
+private:
+    friend class task_details::TaskPromise<T>;
+
+    explicit Task(std::coroutine_handle<promise_type> handle) noexcept
+        : m_handle{handle}
+    {}
+
+    std::coroutine_handle<promise_type> m_handle;
+};
+
+namespace task_details
+{
+    template <typename T>
+    inline Task<T> TaskPromise<T>::get_return_object() noexcept
+    {
+        return Task<T>(std::coroutine_handle<TaskPromise>::from_promise(*this));
+    }
+
+    inline Task<void> TaskPromise<void>::get_return_object() noexcept
+    {
+        return Task<void>(std::coroutine_handle<TaskPromise>::from_promise(*this));
+    }
+}
+
+/// @brief Runs the task and blocks the current thread until its result is ready.
+template <typename T>
+T syncWait(Task<T>&& task)
+{
+    return std::move(task).toFuture().get();
+}
+
+}
+
+#endif // TCLIB_HAS_COROUTINES
+
+#endif // TASK_HPP
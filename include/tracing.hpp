@@ -0,0 +1,129 @@
+#ifndef TRACING_HPP
+#define TRACING_HPP
+
+#include <cstdint>
+#include <exception>
+
+#ifdef TCLIB_ENABLE_TRACING
+#include <atomic>
+#endif
+
+namespace tclib
+{
+
+/// @brief Identity of a shared state in the async call graph.
+/// @details parentId is the id of the shared state the state was created from (by then(),
+/// or by a continuation of the parent running on the current thread), 0 for a root state.
+/// chainId is the id of the root state of the chain.
+struct TraceContext
+{
+    std::uint64_t id = 0;
+    std::uint64_t chainId = 0;
+    std::uint64_t parentId = 0;
+};
+
+/// @brief Tracing hooks invoked by shared states, e.g. to export the async call graph to Chrome trace.
+/// @details The hooks are invoked only if the library is compiled with TCLIB_ENABLE_TRACING
+/// and the hooks are installed with setTraceHooks(). The hooks are called in the thread context
+/// of the event and should be thread safe.
+class TraceHooks
+{
+public:
+    virtual ~TraceHooks() = default;
+
+    virtual void onStateCreated(const TraceContext&) {}
+    virtual void onSetValue(const TraceContext&) {}
+    virtual void onSetException(const TraceContext&, const std::exception_ptr&) {}
+    virtual void onContinuationStart(const TraceContext&) {}
+    virtual void onContinuationEnd(const TraceContext&) {}
+};
+
+#ifdef TCLIB_ENABLE_TRACING
+
+namespace tracing_details
+{
+    inline std::atomic<TraceHooks*>& hooks() noexcept
+    {
+        static std::atomic<TraceHooks*> s_hooks{nullptr};
+        return s_hooks;
+    }
+
+    inline const TraceContext*& currentContext() noexcept
+    {
+        thread_local const TraceContext* s_current = nullptr;
+        return s_current;
+    }
+
+    /// The states created on the current thread within the scope are children of the given context.
+    class TraceScope
+    {
+    public:
+        explicit TraceScope(const TraceContext& context) noexcept
+            : m_previous{currentContext()}
+        {
+            currentContext() = &context;
+        }
+
+        ~TraceScope()
+        {
+            currentContext() = m_previous;
+        }
+
+        TraceScope(const TraceScope&) = delete;
+        TraceScope& operator=(const TraceScope&) = delete;
+
+    private:
+        const TraceContext* m_previous;
+    };
+
+    inline TraceContext makeContext() noexcept
+    {
+        static std::atomic<std::uint64_t> s_nextId{1};
+
+        TraceContext context;
+        context.id = s_nextId.fetch_add(1, std::memory_order_relaxed);
+        if (auto parent = currentContext())
+        {
+            context.chainId = parent->chainId;
+            context.parentId = parent->id;
+        }
+        else
+        {
+            context.chainId = context.id;
+        }
+        return context;
+    }
+}
+
+/// @brief Installs the tracing hooks, nullptr uninstalls them. The hooks should outlive all shared states.
+inline void setTraceHooks(TraceHooks* hooks) noexcept
+{
+    tracing_details::hooks().store(hooks, std::memory_order_release);
+}
+
+inline TraceHooks* getTraceHooks() noexcept
+{
+    return tracing_details::hooks().load(std::memory_order_acquire);
+}
+
+#define TCLIB_TRACE(event, ...) \
+    do \
+    { \
+        if (auto tclibTraceHooks_ = ::tclib::getTraceHooks()) \
+        { \
+            tclibTraceHooks_->event(__VA_ARGS__); \
+        } \
+    } while (false)
+
+#define TCLIB_TRACE_SCOPE(context) ::tclib::tracing_details::TraceScope tclibTraceScope_{context}
+
+#else
+
+#define TCLIB_TRACE(event, ...) ((void)0)
+#define TCLIB_TRACE_SCOPE(context) ((void)0)
+
+#endif // TCLIB_ENABLE_TRACING
+
+}
+
+#endif // TRACING_HPP
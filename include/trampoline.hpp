@@ -0,0 +1,136 @@
+#ifndef TRAMPOLINE_HPP
+#define TRAMPOLINE_HPP
+
+#include <cstddef>
+#include <exception>
+#include <utility>
+#include <vector>
+
+#include "./uniquefunction.hpp"
+
+namespace tclib
+{
+
+namespace trampoline_details
+{
+    /// Maximum number of continuations nested on the stack of a thread, the deeper ones are queued.
+    static constexpr std::size_t s_maxInlineDepth = 16;
+
+    /// @brief Runs the continuations of the current thread with bounded stack depth.
+    /// @details A continuation that completes a shared state runs the continuation of that state,
+    /// so a chain of ready then() would recurse as deep as the chain is long.
+    /// Continuations are run inline up to s_maxInlineDepth nested levels, deeper ones are queued
+    /// and run in FIFO order by the outermost continuation of the thread when it returns.
+    /// The queue is empty when the outermost continuation returns, even if a continuation throws:
+    /// the exception of the outermost continuation is rethrown after the queue is drained,
+    /// otherwise the first exception thrown by a queued continuation is.
+    /// A continuation blocking on a shared state runs the queued continuations first (see runQueued()),
+    /// so it does not wait for a state completed by a continuation queued behind it.
+    class Trampoline
+    {
+    public:
+        /// the continuation is type erased only if it is queued
+        template <typename F>
+        void run(F&& continuation)
+        {
+            if (m_depth >= s_maxInlineDepth)
+            {
+                m_queue.emplace_back(std::forward<F>(continuation));
+                return;
+            }
+
+            DepthGuard guard{m_depth};
+            if (1 != m_depth)
+            {
+                continuation();
+                return;
+            }
+            try
+            {
+                continuation();
+            }
+            catch (...)
+            {
+                runQueued();
+                m_exception = nullptr;
+                throw;
+            }
+            runQueued();
+            if (m_exception)
+            {
+                std::rethrow_exception(std::exchange(m_exception, nullptr));
+            }
+        }
+
+        /// @brief Runs the queued continuations in FIFO order at the current depth,
+        /// the exceptions are kept for the outermost continuation.
+        void runQueued() noexcept
+        {
+            //the queue can grow while a continuation runs, the queued continuation is moved out first
+            while (m_head < m_queue.size())
+            {
+                auto continuation = std::move(m_queue[m_head]);
+                ++m_head;
+                try
+                {
+                    continuation();
+                }
+                catch (...)
+                {
+                    if (!m_exception)
+                    {
+                        m_exception = std::current_exception();
+                    }
+                }
+            }
+            //the capacity is kept for the next chain
+            m_queue.clear();
+            m_head = 0;
+        }
+
+    private:
+        struct DepthGuard
+        {
+            explicit DepthGuard(std::size_t& depth) noexcept
+                : m_depth{depth}
+            {
+                ++m_depth;
+            }
+
+            ~DepthGuard()
+            {
+                --m_depth;
+            }
+
+            std::size_t& m_depth;
+        };
+
+        std::vector<UniqueFunction<void()>> m_queue;
+        std::size_t m_head = 0;
+        std::size_t m_depth = 0;
+        std::exception_ptr m_exception;
+    };
+
+    inline Trampoline& trampoline()
+    {
+        thread_local Trampoline s_trampoline;
+        return s_trampoline;
+    }
+
+    template <typename F>
+    void run(F&& continuation)
+    {
+        trampoline().run(std::forward<F>(continuation));
+    }
+
+    /// Called before the current thread blocks, a continuation of this thread waiting for a state
+    /// completed by a queued continuation would never wake up otherwise.
+    inline void runQueued() noexcept
+    {
+        trampoline().runQueued();
+    }
+}
+
+}
+
+#endif // TRAMPOLINE_HPP
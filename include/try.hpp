@@ -0,0 +1,118 @@
+#ifndef TRY_HPP
+#define TRY_HPP
+
+#include <exception>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+namespace tclib
+{
+
+/// @brief Result of an asynchronous operation, either a value or an exception.
+/// @details The result is inspected without rethrowing the exception, so errors flow
+/// through a chain of thenTry() continuations without exception unwinding.
+template <typename T>
+class Try
+{
+    static_assert(!std::is_same<T, std::exception_ptr>::value, "Try of std::exception_ptr is ambiguous");
+
+public:
+    explicit Try(T value)
+        : m_storage{std::in_place_index<0>, std::move(value)}
+    {}
+
+    explicit Try(std::exception_ptr exc)
+        : m_storage{std::in_place_index<1>, std::move(exc)}
+    {}
+
+    bool hasValue() const noexcept
+    {
+        return (0 == m_storage.index());
+    }
+
+    bool hasException() const noexcept
+    {
+        return (1 == m_storage.index());
+    }
+
+    /// @brief Returns the value or rethrows the exception.
+    T& value() &
+    {
+        throwIfException();
+        return std::get<0>(m_storage);
+    }
+
+    const T& value() const &
+    {
+        throwIfException();
+        return std::get<0>(m_storage);
+    }
+
+    T&& value() &&
+    {
+        throwIfException();
+        return std::move(std::get<0>(m_storage));
+    }
+
+    /// @return the exception or nullptr if the result is a value
+    std::exception_ptr exception() const noexcept
+    {
+        return hasException() ? std::get<1>(m_storage) : nullptr;
+    }
+
+private:
+    void throwIfException() const
+    {
+        if (hasException())
+        {
+            std::rethrow_exception(std::get<1>(m_storage));
+        }
+    }
+
+    std::variant<T, std::exception_ptr> m_storage;
+};
+
+/// Explicit specialization for Try<void>, default constructed Try holds the value.
+template <>
+class Try<void>
+{
+public:
+    Try() = default;
+
+    explicit Try(std::exception_ptr exc) noexcept
+        : m_exception{std::move(exc)}
+    {}
+
+    bool hasValue() const noexcept
+    {
+        return !m_exception;
+    }
+
+    bool hasException() const noexcept
+    {
+        return static_cast<bool>(m_exception);
+    }
+
+    /// @brief Rethrows the exception if any.
+    void value() const
+    {
+        if (m_exception)
+        {
+            std::rethrow_exception(m_exception);
+        }
+    }
+
+    /// @return the exception or nullptr if the result is a value
+    std::exception_ptr exception() const noexcept
+    {
+        return m_exception;
+    }
+
+private:
+    std::exception_ptr m_exception;
+};
+
+}
+
+#endif // TRY_HPP
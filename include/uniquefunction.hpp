@@ -3,6 +3,10 @@
 
 #include <functional>
 #include <type_traits>
+#include <tuple>
+#include <utility>
+
+#include "./stats.hpp"
 
 
 namespace tclib
@@ -37,93 +41,155 @@ namespace tclib
         template <typename T>
         using IsSmall = std::bool_constant<sizeof (T) <= sizeof (Storage::m_tiny)>;
 
+        template <typename C>
+        C* target(Storage& storage) noexcept
+        {
+            if constexpr (IsSmall<C>{})
+            {
+                void* const ptr = std::addressof(storage.m_tiny);
+                return static_cast<C*>(ptr);
+            }
+            else
+            {
+                return static_cast<C*>(storage.m_big);
+            }
+        }
+
+        template <typename Signature>
+        struct Invoker;
+
         template <typename R, typename... Arg>
-        struct Vtable
+        struct Invoker<R(Arg...)>
         {
-            using StorageTypePtr = void*;
             using InvokePtrType = R(*)(Storage&, Arg&&...);
+
+            static R empty(Storage&, Arg&&...)
+            {
+                throw std::bad_function_call();
+            }
+
+            template <typename C>
+            static R invoke(Storage& storage, Arg&&... arg)
+            {
+                return (*target<C>(storage))(std::forward<Arg>(arg)...);
+            }
+        };
+
+        /// Vtable of UniqueFunction, one invoke entry per call signature and shared move/destruct entries.
+        template <typename... Signatures>
+        struct Vtable
+        {
             using MovePtrType = void(*)(Storage&, Storage&);
             using DestructPtrType = void(*)(Storage&);
 
-            const InvokePtrType m_invokePtr;
+            const std::tuple<typename Invoker<Signatures>::InvokePtrType...> m_invokePtrs;
             const MovePtrType m_movePtr;
             const DestructPtrType m_destructPtr;
 
             constexpr Vtable() noexcept
-                : m_invokePtr{[](Storage&, Arg&&...) ->R { throw std::bad_function_call(); }}
+                : m_invokePtrs{&Invoker<Signatures>::empty...}
                 , m_movePtr{[](Storage&, Storage&) noexcept -> void {}}
                 , m_destructPtr{[](Storage&) noexcept -> void {}}
             {}
 
+            //Note: the move entry relocates the callable, the source storage is left without an object,
+            //only the pointer to the big callable is passed to the destination storage
             template <typename C>
-            explicit Vtable(Wrapper<C>) noexcept
-            : Vtable(Wrapper<C>{}, IsSmall<C>{})
-            {}
-
-            template <typename C>
-            Vtable(Wrapper<C>, BigTag) noexcept
-            : m_invokePtr{[](Storage& storagePtr, Arg&&... arg) noexcept(noexcept(std::declval<C>()(arg...))) -> R
+            constexpr explicit Vtable(Wrapper<C>) noexcept
+                : m_invokePtrs{&Invoker<Signatures>::template invoke<C>...}
+                , m_movePtr{[](Storage& dst, Storage& src) noexcept(!IsSmall<C>{} || std::is_nothrow_move_constructible<C>::value) -> void
                             {
-                                return (*static_cast<C*>(storagePtr.m_big))(std::forward<Arg>(arg)...);
+                                if constexpr (IsSmall<C>{})
+                                {
+                                    void* const dstPtr = std::addressof(dst.m_tiny);
+                                    new(dstPtr) C{std::move(*target<C>(src))};
+                                    target<C>(src)->~C();
+                                }
+                                else
+                                {
+                                    dst.m_big = src.m_big;
+                                }
                             }
-                       }
-            , m_movePtr{[](Storage& dstPtr, Storage& srcPtr) ->void
+                           }
+                , m_destructPtr{[](Storage& storage) -> void
                             {
-                                dstPtr.m_big = new C{std::move(*static_cast<C*>(srcPtr.m_big))};
+                                if constexpr (IsSmall<C>{})
+                                {
+                                    target<C>(storage)->~C();
+                                }
+                                else
+                                {
+                                    delete target<C>(storage);
+                                }
                             }
-                       }
-            , m_destructPtr{[](Storage& src) -> void
-                            {
-                                delete static_cast<C*>(src.m_big);
-                            }
-                       }
+                           }
+            {}
+        };
+
+        template <typename... Signatures>
+        inline constexpr Vtable<Signatures...> EmptyVtable{};
+
+        template <typename F, typename... Signatures>
+        inline constexpr Vtable<Signatures...> UniqueFunctionVtable{Wrapper<F>{}};
+
+        /// Provides operator() of a UniqueFunction for the signature with the given index.
+        template <typename Derived, std::size_t Index, typename Signature>
+        struct CallOperator;
+
+        template <typename Derived, std::size_t Index, typename R, typename... Arg>
+        struct CallOperator<Derived, Index, R(Arg...)>
+        {
+            R operator()(Arg... arg) const
             {
+                const auto& self = static_cast<const Derived&>(*this);
+                return std::get<Index>(self.m_vtablePtr->m_invokePtrs)(self.m_storage, std::forward<Arg>(arg)...);
             }
+        };
 
-            template <typename C>
-            Vtable(Wrapper<C>, SmallTag) noexcept
-            : m_invokePtr{[](Storage& storage, Arg&&... arg) noexcept(noexcept(std::declval<C>()(arg...))) -> R
-                            {
-                                //ponters to unrelated types can be casted to each other through void*
-                                void* const ptr = std::addressof(storage.m_tiny);
-                                return (*static_cast<C*>(ptr))(std::forward<Arg>(arg)...);
-                            }
-                        }
-            , m_movePtr{[](Storage& dst, Storage& src) noexcept(std::is_nothrow_move_constructible<C>::value) ->void
-                            {
-                                void* const srcPtr = std::addressof(src.m_tiny);
-                                void* const dstPtr = std::addressof(dst.m_tiny);
-                                new(dstPtr) C{std::move(*static_cast<C*>(srcPtr))};
-                            }
-                       }
-            , m_destructPtr{[](Storage& storage) -> void
-                        {
-                            void* const ptr = std::addressof(storage.m_tiny);
-                            static_cast<C*>(ptr)->~C();
-                        }
-                   }
-                {
-                }
+        template <typename Derived, typename Indices, typename... Signatures>
+        struct CallOperators;
+
+        template <typename Derived, std::size_t... Index, typename... Signatures>
+        struct CallOperators<Derived, std::index_sequence<Index...>, Signatures...>
+            : CallOperator<Derived, Index, Signatures>...
+        {
+            using CallOperator<Derived, Index, Signatures>::operator()...;
         };
+    }
 
+    /// Move-only type erased callable, e.g. UniqueFunction<void()>.
+    /// With several call signatures, e.g. UniqueFunction<void(T&&), void(std::exception_ptr)>,
+    /// the callable is type erased once and all signatures share the same storage,
+    /// the vtable has one invoke entry per signature.
+    template <typename... Signatures>
+    class UniqueFunction final
+        : public uniquefunction_details::CallOperators<
+                    UniqueFunction<Signatures...>,
+                    std::index_sequence_for<Signatures...>,
+                    Signatures...>
+    {
+        static_assert(0 < sizeof...(Signatures), "UniqueFunction requires at least one call signature");
 
-        //Note: variable template (actually is a global variable)
-        template <typename R, typename... Arg>
-        inline constexpr Vtable<R, Arg...> EmptyVtable{};
+    private:
+        using VtableType = uniquefunction_details::Vtable<Signatures...>;
+        using CallOperatorsType = uniquefunction_details::CallOperators<
+                                    UniqueFunction,
+                                    std::index_sequence_for<Signatures...>,
+                                    Signatures...>;
 
-        template <typename F, typename R, typename... Arg>
-        inline Vtable<R, Arg...> UniqueFunctionVtable{Wrapper<F>{}};
-    }
+        template <typename, std::size_t, typename>
+        friend struct uniquefunction_details::CallOperator;
 
-    template <typename Signature>
-    class UniqueFunction;
+        static constexpr const VtableType* emptyVtable() noexcept
+        {
+            return std::addressof(uniquefunction_details::EmptyVtable<Signatures...>);
+        }
 
-    template <typename R, typename... Arg>
-    class UniqueFunction<R(Arg...)> final
-    {
     public:
+        using CallOperatorsType::operator();
+
         UniqueFunction() noexcept
-            : m_vtablePtr{std::addressof(uniquefunction_details::EmptyVtable<R, Arg...>)}
+            : m_vtablePtr{emptyVtable()}
         {}
 
         //std::decay_t models the type conversions applied to function arguments when passed by value
@@ -131,9 +197,8 @@ namespace tclib
         //its's called instead of copy constructor for non-const objects
         template <typename F, typename C = std::decay_t<F>,
                   typename = typename std::enable_if_t<!(std::is_same<C, UniqueFunction>::value)>>
-
         UniqueFunction(F&& closure)
-            : m_vtablePtr{std::addressof(uniquefunction_details::UniqueFunctionVtable<C, R, Arg...>)}
+            : m_vtablePtr{std::addressof(uniquefunction_details::UniqueFunctionVtable<C, Signatures...>)}
         {
             if constexpr (uniquefunction_details::IsSmall<C>{})
             {
@@ -141,18 +206,19 @@ namespace tclib
             }
             else
             {
+                TCLIB_STATS_ADD(uniqueFunctionHeapAllocations, 1);
                 m_storage.m_big = new C{std::forward<F>(closure)};
             }
         }
 
         //Without this constructor the code UniqueFunction f(nullptr); - does not compile
         constexpr UniqueFunction(std::nullptr_t)
-            : m_vtablePtr{std::addressof(uniquefunction_details::EmptyVtable<R, Arg...>)} {}
+            : m_vtablePtr{emptyVtable()} {}
 
         UniqueFunction& operator=(std::nullptr_t)
         {
             m_vtablePtr->m_destructPtr(m_storage);
-            m_vtablePtr = std::addressof(uniquefunction_details::EmptyVtable<R, Arg...>);
+            m_vtablePtr = emptyVtable();
             return *this;
         }
 
@@ -160,8 +226,7 @@ namespace tclib
         UniqueFunction& operator=(const UniqueFunction&) = delete;
 
         UniqueFunction(UniqueFunction&& other)
-            : m_vtablePtr{std::exchange(other.m_vtablePtr,
-                                        std::addressof(uniquefunction_details::EmptyVtable<R, Arg...>))}
+            : m_vtablePtr{std::exchange(other.m_vtablePtr, emptyVtable())}
         {
             m_vtablePtr->m_movePtr(m_storage, other.m_storage);
         }
@@ -173,21 +238,15 @@ namespace tclib
                 //Note: call destructor because we will create/inplace a new object and the existing one should be destructed.
                 m_vtablePtr->m_destructPtr(m_storage);
 
-                m_vtablePtr = std::exchange(other.m_vtablePtr,
-                                            std::addressof(uniquefunction_details::EmptyVtable<R, Arg...>));
+                m_vtablePtr = std::exchange(other.m_vtablePtr, emptyVtable());
                 m_vtablePtr->m_movePtr(m_storage, other.m_storage);
             }
             return *this;
         }
 
-        R operator()(Arg... arg) const
-        {
-            return m_vtablePtr->m_invokePtr(m_storage, std::forward<Arg>(arg)...);
-        }
-
         explicit operator bool() const noexcept
         {
-            return (m_vtablePtr != std::addressof(uniquefunction_details::EmptyVtable<R, Arg...>));
+            return (m_vtablePtr != emptyVtable());
         }
 
         bool operator==(std::nullptr_t) const noexcept
@@ -225,20 +284,18 @@ namespace tclib
         }
 
     private:
-        using VtableType = uniquefunction_details::Vtable<R, Arg...>;
-
         const VtableType* m_vtablePtr;
         mutable uniquefunction_details::Storage m_storage;
     };
 
-    template <typename R, typename... Arg>
-    inline bool operator==(std::nullptr_t, const UniqueFunction<R(Arg...)>& f) noexcept
+    template <typename... Signatures>
+    inline bool operator==(std::nullptr_t, const UniqueFunction<Signatures...>& f) noexcept
     {
         return (f == nullptr);
     }
 
-    template <typename R, typename... Arg>
-    inline bool operator!=(std::nullptr_t, const UniqueFunction<R(Arg...)>& f) noexcept
+    template <typename... Signatures>
+    inline bool operator!=(std::nullptr_t, const UniqueFunction<Signatures...>& f) noexcept
     {
         return (f != nullptr);
     }
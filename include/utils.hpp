@@ -1,13 +1,74 @@
 #ifndef UTILS_HPP
 #define UTILS_HPP
 
+#include <cstddef>
 #include <stdexcept>
 
 #include "future_errorcodes.hpp"
 
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+#if __has_include(<coroutine>)
+#define TCLIB_HAS_COROUTINES 1
+#endif
+#endif
+
+#ifndef TCLIB_HAS_COROUTINES
+#define TCLIB_HAS_COROUTINES 0
+#endif
+
+#if TCLIB_HAS_COROUTINES
+#include <coroutine>
+#endif
+
+//aligns the hot member groups of shared states to separate cache lines, trading memory for less false sharing
+#ifdef TCLIB_ENABLE_CACHE_LINE_LAYOUT
+#define TCLIB_CACHE_LINE_ALIGNED alignas(::tclib::s_cacheLineSize)
+#else
+#define TCLIB_CACHE_LINE_ALIGNED
+#endif
+
 namespace tclib
 {
 
+/// Assumed size of a cache line, std::hardware_destructive_interference_size is not used
+/// because its value depends on the compiler flags of the translation unit.
+static constexpr std::size_t s_cacheLineSize = 64;
+
+namespace coroutine_details
+{
+    /// @brief Suspended coroutine stored without std::coroutine_handle: the address of its frame
+    /// and the function resuming it.
+    /// @details The states holding suspended coroutines have the same definition in C++17 and C++20
+    /// translation units, so a program can mix them, only the awaiters creating the reference require C++20.
+    struct CoroutineRef
+    {
+        void* m_address = nullptr;
+        void (*m_resume)(void*) = nullptr;
+
+        explicit operator bool() const noexcept
+        {
+            return nullptr != m_address;
+        }
+
+        void operator()() const
+        {
+            m_resume(m_address);
+        }
+    };
+
+#if TCLIB_HAS_COROUTINES
+    inline void resume(void* address)
+    {
+        std::coroutine_handle<>::from_address(address).resume();
+    }
+
+    inline CoroutineRef makeCoroutineRef(std::coroutine_handle<> handle) noexcept
+    {
+        return CoroutineRef{handle.address(), &resume};
+    }
+#endif
+}
+
 inline const char* toString(FutureErrorCode code) noexcept
 {
     switch (code)
@@ -20,6 +81,8 @@ inline const char* toString(FutureErrorCode code) noexcept
         return "promise_already_satisfied";
     case FutureErrorCode::no_state:
         return "no_state";
+    case FutureErrorCode::cancelled:
+        return "cancelled";
     }
 }
 
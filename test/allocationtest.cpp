@@ -0,0 +1,446 @@
+#include "catch2/catch.hpp"
+
+#include <array>
+#include <cstdlib>
+#include <new>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "future.hpp"
+#include "packagedtask.hpp"
+#include "promisearray.hpp"
+#include "task.hpp"
+#include "uniquefunction.hpp"
+
+//Note: the global allocation functions are replaced for the whole test executable,
+//the allocations are counted only on the thread and in the scope of an AllocationCounter
+namespace
+{
+    thread_local std::size_t* t_allocations = nullptr;
+
+    /// Counts the allocations of the current thread from construction to destruction.
+    class AllocationCounter
+    {
+    public:
+        AllocationCounter() noexcept
+            : m_previous{t_allocations}
+        {
+            t_allocations = &m_allocations;
+        }
+
+        ~AllocationCounter()
+        {
+            t_allocations = m_previous;
+        }
+
+        AllocationCounter(const AllocationCounter&) = delete;
+        AllocationCounter& operator=(const AllocationCounter&) = delete;
+
+        std::size_t allocations() const noexcept
+        {
+            return m_allocations;
+        }
+
+    private:
+        std::size_t m_allocations = 0;
+        std::size_t* m_previous;
+    };
+
+    template <typename F>
+    std::size_t countAllocations(F&& f)
+    {
+#ifdef TCLIB_ENABLE_STATS
+        //the counters of the thread are allocated and registered on first use
+        tclib::stats_details::threadCounters();
+#endif
+        AllocationCounter counter;
+        f();
+        return counter.allocations();
+    }
+}
+
+namespace
+{
+    void* allocate(std::size_t size) noexcept
+    {
+        if (nullptr != t_allocations)
+        {
+            ++*t_allocations;
+        }
+        return std::malloc((0 != size) ? size : 1);
+    }
+
+    void* allocate(std::size_t size, std::align_val_t alignment) noexcept
+    {
+        if (nullptr != t_allocations)
+        {
+            ++*t_allocations;
+        }
+        const auto align = static_cast<std::size_t>(alignment);
+        return std::aligned_alloc(align, (0 != size) ? (size + align - 1) / align * align : align);
+    }
+
+    template <typename... Alignment>
+    void* allocateOrThrow(std::size_t size, Alignment... alignment)
+    {
+        if (void* ptr = allocate(size, alignment...))
+        {
+            return ptr;
+        }
+        throw std::bad_alloc();
+    }
+}
+
+//all forms are replaced, the memory allocated by any of them (e.g. nothrow new used by catch2)
+//is released by the replaced operator delete
+
+void* operator new(std::size_t size)
+{
+    return allocateOrThrow(size);
+}
+
+void* operator new[](std::size_t size)
+{
+    return allocateOrThrow(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    return allocate(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    return allocate(size);
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept
+{
+    std::free(ptr);
+}
+
+//over-aligned types, e.g. the cache line aligned states of PromiseArray
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+    return allocateOrThrow(size, alignment);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment)
+{
+    return allocateOrThrow(size, alignment);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return allocate(size, alignment);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return allocate(size, alignment);
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t, const std::nothrow_t&) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t, const std::nothrow_t&) noexcept
+{
+    std::free(ptr);
+}
+
+TEST_CASE("AllocationTest, testPromiseAndFuture")
+{
+    //one allocation for the shared state (and its control block)
+    std::optional<tclib::Promise<std::int32_t>> promise;
+    CHECK(countAllocations([&promise]() { promise.emplace(); }) == 1);
+
+    std::optional<tclib::Future<std::int32_t>> future;
+    CHECK(countAllocations([&]() { future.emplace(promise->getFuture()); }) == 0);
+    CHECK(countAllocations([&]() { promise->setValue(1); }) == 0);
+    CHECK(countAllocations([&]() { REQUIRE(future->get() == 1); }) == 0);
+}
+
+TEST_CASE("AllocationTest, testUnusedPromiseDestruction")
+{
+    //the broken_promise error is not created if no future has been retrieved
+    std::optional<tclib::Promise<std::int32_t>> promise{std::in_place};
+    CHECK(countAllocations([&promise]() { promise.reset(); }) == 0);
+
+    //nor if the future is already gone
+    promise.emplace();
+    promise->getFuture();
+    CHECK(countAllocations([&promise]() { promise.reset(); }) == 0);
+}
+
+TEST_CASE("AllocationTest, testShare")
+{
+    tclib::Promise<std::int32_t> promise;
+    auto future = promise.getFuture();
+
+    std::optional<tclib::SharedFuture<std::int32_t>> sharedFuture;
+    CHECK(countAllocations([&]() { sharedFuture.emplace(future.share()); }) == 0);
+    CHECK(countAllocations([&]() { auto copy = *sharedFuture; }) == 0);
+}
+
+TEST_CASE("AllocationTest, testThen")
+{
+    tclib::Promise<std::int32_t> promise;
+    auto future = promise.getFuture();
+
+    std::optional<tclib::Future<std::int32_t>> thenFuture;
+    const auto thenAllocations = countAllocations([&]()
+    {
+        thenFuture.emplace(future.then([](tclib::Future<std::int32_t> f) { return f.get() + 1; }));
+    });
+    //the shared state of the new future and the continuation capturing the promise and the callable,
+    //the link forwarding interrupts to the pending state is stored in the new state
+    CHECK(thenAllocations == 2);
+    CHECK(countAllocations([&]() { promise.setValue(1); }) == 0);
+    REQUIRE(thenFuture->get() == 2);
+}
+
+TEST_CASE("AllocationTest, testThenUnwrapsFuture")
+{
+    tclib::Promise<std::int32_t> promise;
+    tclib::Promise<std::int32_t> inner;
+    auto innerFuture = inner.getFuture();
+    auto future = promise.getFuture();
+
+    std::optional<tclib::Future<std::int32_t>> thenFuture;
+    CHECK(countAllocations([&]()
+    {
+        thenFuture.emplace(future.then([&innerFuture](tclib::Future<std::int32_t>) { return std::move(innerFuture); }));
+    }) == 2);
+    //the inner future completes the promise of the continuation directly, no intermediate state
+    CHECK(countAllocations([&]() { promise.setValue(1); }) == 0);
+    CHECK(countAllocations([&]() { inner.setValue(2); }) == 0);
+    REQUIRE(thenFuture->get() == 2);
+}
+
+TEST_CASE("AllocationTest, testDeferredPipeline")
+{
+    tclib::Promise<std::int32_t> promise;
+    auto future = promise.getFuture();
+
+    //the stages are fused into one continuation with one shared state
+    std::optional<tclib::Future<std::int32_t>> pipelineFuture;
+    const auto pipelineAllocations = countAllocations([&]()
+    {
+        pipelineFuture.emplace(std::move(future)
+                .defer()
+                .then([](std::int32_t v) { return v + 1; })
+                .then([](std::int32_t v) { return v + 1; })
+                .then([](std::int32_t v) { return v + 1; })
+                .then([](std::int32_t v) { return v + 1; })
+                .then([](std::int32_t v) { return v + 1; })
+                .toFuture());
+    });
+    CHECK(pipelineAllocations == 2);
+    promise.setValue(0);
+    REQUIRE(pipelineFuture->get() == 5);
+}
+
+TEST_CASE("AllocationTest, testPackagedTask")
+{
+    std::int64_t value = 42;
+
+    //the callable is embedded in the shared state
+    std::optional<tclib::PackagedTask<std::int64_t()>> task;
+    CHECK(countAllocations([&]() { task.emplace([value]() { return value; }); }) == 1);
+
+    auto future = task->getFuture();
+    std::optional<tclib::UniqueFunction<void()>> queued;
+    CHECK(countAllocations([&]() { queued.emplace(std::move(*task)); }) == 0);
+    CHECK(countAllocations([&]() { (*queued)(); }) == 0);
+    REQUIRE(future.get() == 42);
+}
+
+TEST_CASE("AllocationTest, testFulfilAll")
+{
+    std::vector<std::pair<tclib::Promise<std::int32_t>, std::int32_t>> responses(64);
+    std::vector<tclib::Future<std::int32_t>> futures;
+    for (auto& response : responses)
+    {
+        futures.push_back(response.first.getFuture().thenValue([](std::int32_t v) { return v + 1; }));
+    }
+
+    //one batch of continuations passed to the executor as one job,
+    //the instrumented continuations do not fit the small buffer and are allocated when batched
+#if defined(TCLIB_ENABLE_TRACING) || defined(TCLIB_ENABLE_LATENCY_STATS)
+    const std::size_t expected = 1 + responses.size();
+#else
+    const std::size_t expected = 1;
+#endif
+    std::optional<tclib::UniqueFunction<void()>> job;
+    CHECK(countAllocations([&]()
+    {
+        tclib::fulfilAll(responses, [&job](tclib::UniqueFunction<void()> j) { job.emplace(std::move(j)); });
+    }) == expected);
+    CHECK(countAllocations([&]() { (*job)(); }) == 0);
+    REQUIRE(futures.back().get() == 1);
+}
+
+TEST_CASE("AllocationTest, testPromiseArray")
+{
+    //the block of states, its reference count and the vector of promises, regardless of the size
+    std::optional<tclib::PromiseArray<std::int32_t>> promises;
+    CHECK(countAllocations([&]() { promises.emplace(1000); }) == 3);
+
+    std::optional<tclib::FutureArray<std::int32_t>> futures;
+    CHECK(countAllocations([&]() { futures.emplace(promises->getFutures()); }) == 1);
+
+    //the shared object of the continuations and the state of the result
+    std::optional<tclib::Future<std::vector<std::int32_t>>> all;
+    CHECK(countAllocations([&]() { all.emplace(std::move(*futures).whenAll()); }) == 2);
+
+    for (auto& promise : *promises)
+    {
+        promise.setValue(1);
+    }
+    REQUIRE(all->get().size() == 1000);
+}
+
+TEST_CASE("AllocationTest, testUniqueFunctionMove")
+{
+    std::array<std::int64_t, 2> small{{1, 2}};
+    std::array<std::int64_t, 16> big{{1, 2}};
+
+    std::optional<tclib::UniqueFunction<std::int64_t()>> smallFunction;
+    std::optional<tclib::UniqueFunction<std::int64_t()>> bigFunction;
+    CHECK(countAllocations([&]() { smallFunction.emplace([small]() { return small[1]; }); }) == 0);
+    CHECK(countAllocations([&]() { bigFunction.emplace([big]() { return big[1]; }); }) == 1);
+
+    //moves relocate the callable, the heap allocated callable is not copied
+    CHECK(countAllocations([&]()
+    {
+        auto moved = std::move(*smallFunction);
+        *smallFunction = std::move(moved);
+    }) == 0);
+    CHECK(countAllocations([&]()
+    {
+        auto moved = std::move(*bigFunction);
+        *bigFunction = std::move(moved);
+        swap(*bigFunction, moved);
+        swap(*bigFunction, moved);
+    }) == 0);
+    REQUIRE((*smallFunction)() == 2);
+    REQUIRE((*bigFunction)() == 2);
+}
+
+#if TCLIB_HAS_COROUTINES
+namespace
+{
+    tclib::Task<std::int32_t> answer()
+    {
+        co_return 42;
+    }
+
+    tclib::Task<std::int32_t> awaitAnswer()
+    {
+        co_return co_await answer();
+    }
+
+    tclib::Task<std::int32_t> awaitFuture(tclib::Future<std::int32_t> future)
+    {
+        co_return co_await std::move(future);
+    }
+
+    tclib::Task<std::int32_t> awaitSharedFuture(tclib::SharedFuture<std::int32_t> future)
+    {
+        co_return co_await future;
+    }
+}
+
+TEST_CASE("AllocationTest, testTask")
+{
+    //one allocation per coroutine frame, the shared state is allocated only when the task is converted to a future,
+    //syncWait() converts the outer task: two frames and the state
+    CHECK(countAllocations([]() { auto task = answer(); }) == 1);
+    CHECK(countAllocations([]()
+    {
+        auto task = awaitAnswer();
+        REQUIRE(tclib::syncWait(std::move(task)) == 42);
+    }) == 3);
+}
+
+TEST_CASE("AllocationTest, testAwaitPendingFuture")
+{
+    tclib::Promise<std::int32_t> promise;
+    auto future = promise.getFuture();
+
+    //the coroutine frame, then the state of the task future, the coroutine suspended on the pending future
+    //is registered in the state it awaits without an allocation
+    std::optional<tclib::Task<std::int32_t>> task;
+    CHECK(countAllocations([&]() { task.emplace(awaitFuture(std::move(future))); }) == 1);
+    std::optional<tclib::Future<std::int32_t>> taskFuture;
+    CHECK(countAllocations([&]() { taskFuture.emplace(std::move(*task).toFuture()); }) == 1);
+    CHECK(countAllocations([&]() { promise.setValue(42); }) == 0);
+    REQUIRE(taskFuture->get() == 42);
+}
+
+TEST_CASE("AllocationTest, testAwaitPendingSharedFuture")
+{
+    tclib::Promise<std::int32_t> promise;
+    auto future = promise.getFuture().share();
+
+    //the frame and the state of the task future per coroutine, nothing per awaiter
+    std::vector<tclib::Future<std::int32_t>> taskFutures;
+    taskFutures.reserve(2);
+    CHECK(countAllocations([&]()
+    {
+        taskFutures.push_back(awaitSharedFuture(future).toFuture());
+        taskFutures.push_back(awaitSharedFuture(future).toFuture());
+    }) == 4);
+    CHECK(countAllocations([&]() { promise.setValue(42); }) == 0);
+    REQUIRE(taskFutures[0].get() == 42);
+    REQUIRE(taskFutures[1].get() == 42);
+}
+#endif
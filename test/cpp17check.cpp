@@ -0,0 +1,99 @@
+//Compiled as C++17 without a test runner, the headers must build without C++20 (and without coroutines).
+//The templates are instantiated here, the errors of their members are reported only on instantiation.
+//The object file is also linked into the C++20 tests, see mixedstandardtest.cpp.
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "cpp17check.hpp"
+#include "future.hpp"
+#include "packagedtask.hpp"
+#include "promisearray.hpp"
+#include "stream.hpp"
+#include "task.hpp"
+
+static_assert(__cplusplus < 202002L, "cpp17check.cpp must be compiled as C++17");
+
+namespace
+{
+    template <typename T>
+    void instantiate(T value)
+    {
+        tclib::Promise<T> promise;
+        auto future = promise.getFuture();
+        auto thenFuture = future.then([](tclib::Future<T> f) { return f.get(); })
+                .thenValue([](T v) { return v; })
+                .thenTry([](tclib::Try<T>&& t) { return std::move(t).value(); })
+                .template thenError<std::exception>([](std::exception&) { return T(); });
+        auto deferred = std::move(thenFuture).defer().then([](T v) { return v; }).toFuture();
+        promise.setInterruptHandler([](std::exception_ptr) {});
+        promise.setAbandonedHandler([]() {});
+        promise.setValue(std::move(value));
+        deferred.cancel();
+        deferred.getTry();
+
+        tclib::Promise<void> voidPromise;
+        auto shared = voidPromise.getFuture().share();
+        voidPromise.setException(std::make_exception_ptr(std::runtime_error("error")));
+        shared.getTry();
+
+        std::vector<std::pair<tclib::Promise<T>, T>> responses(1);
+        auto responseFuture = responses.front().first.getFuture();
+        tclib::fulfilAll(responses);
+        responseFuture.get();
+
+        tclib::PromiseArray<T> promises(2);
+        auto all = promises.getFutures().whenAll();
+
+        tclib::PackagedTask<T(T)> task([](T v) { return v; });
+        auto taskFuture = task.getFuture();
+        task(T());
+
+        tclib::StreamPromise<T> streamPromise;
+        auto stream = streamPromise.getStream();
+        streamPromise.push(T());
+        streamPromise.close();
+        stream.get();
+    }
+}
+
+void instantiateCpp17()
+{
+    instantiate<std::int32_t>(1);
+    instantiate<std::string>("value");
+}
+
+namespace cpp17check
+{
+    tclib::Promise<Value> makePromise()
+    {
+        return tclib::Promise<Value>();
+    }
+
+    void setValue(tclib::Promise<Value>& promise, std::int32_t value)
+    {
+        promise.setValue(Value{value});
+    }
+
+    tclib::StreamPromise<Value> makeStreamPromise(std::size_t capacity)
+    {
+        return tclib::StreamPromise<Value>(capacity);
+    }
+
+    void push(tclib::StreamPromise<Value>& promise, std::int32_t value)
+    {
+        promise.push(Value{value});
+    }
+
+    void close(tclib::StreamPromise<Value>& promise)
+    {
+        promise.close();
+    }
+
+    std::int32_t pop(tclib::Stream<Value>& stream)
+    {
+        auto value = stream.get();
+        return value ? value->m_value : -1;
+    }
+}
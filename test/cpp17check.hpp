@@ -0,0 +1,33 @@
+#ifndef CPP17CHECK_HPP
+#define CPP17CHECK_HPP
+
+#include <cstdint>
+
+#include "future.hpp"
+#include "stream.hpp"
+
+/// Functions defined in cpp17check.cpp, which is compiled as C++17 and linked into the C++20 tests.
+/// The shared states of Value are created and set only by the C++17 code and awaited by the C++20 code,
+/// so the C++17 definitions of their members are the only ones in the program.
+namespace cpp17check
+{
+    struct Value
+    {
+        std::int32_t m_value;
+    };
+
+    tclib::Promise<Value> makePromise();
+
+    void setValue(tclib::Promise<Value>& promise, std::int32_t value);
+
+    tclib::StreamPromise<Value> makeStreamPromise(std::size_t capacity);
+
+    void push(tclib::StreamPromise<Value>& promise, std::int32_t value);
+
+    void close(tclib::StreamPromise<Value>& promise);
+
+    /// @return the next value, -1 when the stream is closed
+    std::int32_t pop(tclib::Stream<Value>& stream);
+}
+
+#endif // CPP17CHECK_HPP
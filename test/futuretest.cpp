@@ -1,6 +1,12 @@
 #include "catch2/catch.hpp"
 
+#include <atomic>
 #include <future>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
 #include "future.hpp"
 
 TEST_CASE("FutureTest, testSharedState")
@@ -313,3 +319,791 @@ TEST_CASE("FutureTest, testPromiseAndFutureVoid")
     popDone.get();
     REQUIRE_FALSE(future.valid());
 }
+
+TEST_CASE("FutureTest, testCancellationToken")
+{
+    tclib::CancellationSource source;
+    tclib::CancellationToken token = source.getToken();
+
+    REQUIRE(token.canBeCancelled());
+    REQUIRE_FALSE(token.isCancellationRequested());
+
+    source.requestCancellation();
+    REQUIRE(token.isCancellationRequested());
+    REQUIRE(source.isCancellationRequested());
+
+    REQUIRE_FALSE(tclib::CancellationToken().canBeCancelled());
+    REQUIRE_FALSE(tclib::CancellationToken().isCancellationRequested());
+}
+
+TEST_CASE("FutureTest, testCancellationPropagatedThroughThen")
+{
+    tclib::CancellationSource source;
+    tclib::Promise<std::int32_t> promise;
+    promise.setCancellationToken(source.getToken());
+
+    std::int32_t calls = 0;
+    auto counted = [&calls](tclib::Future<std::int32_t> future)
+    {
+        ++calls;
+        return future.get() * 2;
+    };
+    auto then = promise.getFuture().then(counted).then(counted);
+
+    REQUIRE_FALSE(promise.isCancellationRequested());
+    source.requestCancellation();
+    REQUIRE(promise.isCancellationRequested());
+
+    promise.setValue(42);
+
+    REQUIRE(0 == calls);
+    REQUIRE_THROWS_AS(then.get(), tclib::FutureError);
+}
+
+TEST_CASE("FutureTest, testCancellationTokenAttachedToFuture")
+{
+    tclib::CancellationSource source;
+    tclib::Promise<void> promise;
+    tclib::Future<void> future = promise.getFuture();
+    future.setCancellationToken(source.getToken());
+
+    auto called = false;
+    auto then = future.then([&called](tclib::Future<void>) { called = true; return called; });
+
+    promise.setValue();
+    REQUIRE(then.get());
+    REQUIRE_FALSE(promise.isCancellationRequested());
+}
+
+TEST_CASE("FutureTest, testCancellationTokenAttachedWhileProducerChecks")
+{
+    tclib::CancellationSource source;
+    tclib::Promise<void> promise;
+    tclib::Future<void> future = promise.getFuture();
+
+    //the producer polls the state while the consumer attaches the token
+    auto producer = std::async(std::launch::async, [&promise]()
+    {
+        while (!promise.isCancellationRequested())
+        {
+            std::this_thread::yield();
+        }
+        promise.setValue();
+    });
+
+    future.setCancellationToken(source.getToken());
+    source.requestCancellation();
+    producer.get();
+    REQUIRE_NOTHROW(future.get());
+}
+
+TEST_CASE("FutureTest, testCancellationTokenReplaced")
+{
+    tclib::CancellationSource first;
+    tclib::CancellationSource second;
+    tclib::Promise<void> promise;
+    tclib::Future<void> future = promise.getFuture();
+
+    promise.setCancellationToken(first.getToken());
+    future.setCancellationToken(second.getToken());
+
+    first.requestCancellation();
+    REQUIRE_FALSE(promise.isCancellationRequested());
+    second.requestCancellation();
+    REQUIRE(promise.isCancellationRequested());
+}
+
+TEST_CASE("FutureTest, testInterruptHandler")
+{
+    tclib::Promise<std::int32_t> promise;
+    tclib::Future<std::int32_t> future = promise.getFuture();
+
+    std::int32_t calls = 0;
+    promise.setInterruptHandler([&promise, &calls](std::exception_ptr exc)
+    {
+        ++calls;
+        promise.setException(exc);
+    });
+
+    future.cancel();
+    future.cancel();
+
+    REQUIRE(1 == calls);
+    REQUIRE_THROWS_AS(future.get(), tclib::FutureError);
+}
+
+TEST_CASE("FutureTest, testInterruptRaisedBeforeHandlerIsSet")
+{
+    tclib::Promise<void> promise;
+    tclib::Future<void> future = promise.getFuture();
+
+    future.raise(std::make_exception_ptr(std::logic_error("Not needed!")));
+
+    std::exception_ptr interrupt;
+    promise.setInterruptHandler([&interrupt](std::exception_ptr exc) { interrupt = exc; });
+
+    REQUIRE(interrupt);
+    REQUIRE_THROWS_AS(std::rethrow_exception(interrupt), std::logic_error);
+}
+
+TEST_CASE("FutureTest, testInterruptIgnoredAfterPromiseIsSatisfied")
+{
+    tclib::Promise<std::int32_t> promise;
+    tclib::Future<std::int32_t> future = promise.getFuture();
+
+    auto called = false;
+    promise.setInterruptHandler([&called](std::exception_ptr) { called = true; });
+    promise.setValue(42);
+
+    future.cancel();
+    REQUIRE_FALSE(called);
+    REQUIRE(42 == future.get());
+}
+
+TEST_CASE("FutureTest, testInterruptPropagatedThroughThen")
+{
+    tclib::Promise<std::int32_t> promise;
+
+    auto interrupted = false;
+    promise.setInterruptHandler([&interrupted](std::exception_ptr) { interrupted = true; });
+
+    auto then = promise.getFuture().then(f).then(f);
+    then.cancel();
+
+    REQUIRE(interrupted);
+}
+
+TEST_CASE("FutureTest, testInterruptHandlerSetAfterThen")
+{
+    tclib::Promise<std::int32_t> promise;
+    auto then = promise.getFuture().then(f).then(f);
+
+    //raised before and after the handler is set
+    then.cancel();
+    std::int32_t calls = 0;
+    promise.setInterruptHandler([&calls](std::exception_ptr) { ++calls; });
+    REQUIRE(1 == calls);
+
+    tclib::Promise<std::int32_t> other;
+    auto otherThen = other.getFuture().then(f);
+    std::int32_t otherCalls = 0;
+    other.setInterruptHandler([&otherCalls](std::exception_ptr) { ++otherCalls; });
+    otherThen.cancel();
+    REQUIRE(1 == otherCalls);
+}
+
+TEST_CASE("FutureTest, testInterruptPropagatedThroughThenOfOtherTypes")
+{
+    tclib::Promise<std::int32_t> promise;
+    std::int32_t calls = 0;
+    promise.setInterruptHandler([&calls](std::exception_ptr) { ++calls; });
+
+    auto then = promise.getFuture()
+            .thenValue([](std::int32_t v) { return std::to_string(v); })
+            .thenValue([](std::string) {})
+            .thenValue([]() { return 42; });
+    then.cancel();
+    then.cancel();
+    REQUIRE(1 == calls);
+}
+
+TEST_CASE("FutureTest, testInterruptRacesWithCompletionOfChain")
+{
+    //the chain is completed while the interrupt walks it, the states released by the continuations are not visited
+    for (std::int32_t i = 0; i < 1000; ++i)
+    {
+        tclib::Promise<std::int32_t> promise;
+        std::atomic<std::int32_t> calls{0};
+        promise.setInterruptHandler([&calls](std::exception_ptr) { ++calls; });
+        auto then = promise.getFuture()
+                .then([](tclib::Future<std::int32_t> future) { return future.get() + 1; })
+                .thenValue([](std::int32_t v) { return std::to_string(v); })
+                .thenValue([](std::string v) { return static_cast<std::int32_t>(v.size()); });
+
+        std::promise<void> go;
+        std::shared_future<void> ready(go.get_future());
+        auto setDone = std::async(std::launch::async, [&promise, ready]()
+        {
+            ready.wait();
+            promise.setValue(1);
+        });
+        go.set_value();
+        then.cancel();
+        setDone.get();
+
+        REQUIRE(calls <= 1);
+        REQUIRE(1 == then.get());
+    }
+}
+
+TEST_CASE("FutureTest, testBrokenPromiseWakesWaiter")
+{
+    auto promise = std::make_unique<tclib::Promise<std::int32_t>>();
+    tclib::Future<std::int32_t> future = promise->getFuture();
+
+    std::promise<void> waitReady;
+    auto waitDone = std::async(std::launch::async, [&future, &waitReady]()
+    {
+        waitReady.set_value();
+        return future.get();
+    });
+
+    waitReady.get_future().wait();
+    promise.reset();
+
+    REQUIRE_THROWS_AS(waitDone.get(), tclib::FutureError);
+}
+
+TEST_CASE("FutureTest, testBrokenPromiseRunsContinuations")
+{
+    auto sp = std::make_shared<std::int32_t>(42);
+    tclib::Future<std::int32_t> then;
+    {
+        tclib::Promise<std::int32_t> promise;
+        then = promise.getFuture().then([sp](tclib::Future<std::int32_t> future) { return future.get(); });
+        REQUIRE(2 == sp.use_count());
+    }
+    REQUIRE(1 == sp.use_count());
+    REQUIRE_THROWS_AS(then.get(), tclib::FutureError);
+}
+
+TEST_CASE("FutureTest, testPromiseMoveAssignmentBreaksPromise")
+{
+    tclib::Promise<void> promise;
+    tclib::Future<void> future = promise.getFuture();
+
+    promise = tclib::Promise<void>();
+
+    REQUIRE_THROWS_AS(future.get(), tclib::FutureError);
+    REQUIRE_NOTHROW(promise.getFuture());
+}
+
+TEST_CASE("FutureTest, testPromiseIsAbandoned")
+{
+    tclib::Promise<std::int32_t> promise;
+    REQUIRE_FALSE(promise.isAbandoned());
+
+    auto abandoned = false;
+    promise.setAbandonedHandler([&abandoned]() { abandoned = true; });
+    {
+        tclib::SharedFuture<std::int32_t> sharedFuture = promise.getFuture().share();
+        auto sharedFuture2 = sharedFuture;
+        REQUIRE_FALSE(promise.isAbandoned());
+
+        sharedFuture = tclib::SharedFuture<std::int32_t>();
+        REQUIRE_FALSE(promise.isAbandoned());
+        REQUIRE_FALSE(abandoned);
+    }
+    REQUIRE(promise.isAbandoned());
+    REQUIRE(abandoned);
+}
+
+TEST_CASE("FutureTest, testPromiseIsNotAbandonedAfterGet")
+{
+    tclib::Promise<std::int32_t> promise;
+
+    auto abandoned = false;
+    promise.setAbandonedHandler([&abandoned]() { abandoned = true; });
+
+    auto then = promise.getFuture().then(f);
+    REQUIRE_FALSE(promise.isAbandoned());
+
+    promise.setValue(42);
+    REQUIRE(42 * 2 == then.get());
+    REQUIRE_FALSE(abandoned);
+}
+
+TEST_CASE("FutureTest, testDiscardedContinuationRuns")
+{
+    tclib::Promise<std::int32_t> promise;
+
+    auto abandoned = false;
+    promise.setAbandonedHandler([&abandoned]() { abandoned = true; });
+
+    std::int32_t ran = 0;
+    promise.getFuture().then([&ran](tclib::Future<std::int32_t> future) { ran = future.get(); return 0; });
+    REQUIRE_FALSE(promise.isAbandoned());
+
+    promise.setValue(7);
+    REQUIRE(7 == ran);
+    REQUIRE_FALSE(abandoned);
+}
+
+TEST_CASE("FutureTest, testFutureThenReturningVoid")
+{
+    tclib::Promise<std::int32_t> promise;
+    std::int32_t result = 0;
+    auto future = promise.getFuture().then([&result](tclib::Future<std::int32_t> f) { result = f.get(); });
+    promise.setValue(42);
+    future.get();
+    REQUIRE(42 == result);
+}
+
+TEST_CASE("FutureTest, testDeferredFuture")
+{
+    tclib::Promise<std::int32_t> promise;
+    auto future = promise.getFuture()
+            .defer()
+            .then([](std::int32_t v) { return v + 1; })
+            .then([](std::int32_t v) { return std::to_string(v); })
+            .then([](std::string s) { return s + "!"; })
+            .toFuture();
+    promise.setValue(41);
+    REQUIRE("42!" == future.get());
+}
+
+TEST_CASE("FutureTest, testDeferredFutureVoidStages")
+{
+    tclib::Promise<void> promise;
+    std::int32_t calls = 0;
+    auto future = promise.getFuture()
+            .defer()
+            .then([&calls]() { ++calls; })
+            .then([&calls]() { ++calls; return calls; })
+            .toFuture();
+    promise.setValue();
+    REQUIRE(2 == future.get());
+}
+
+TEST_CASE("FutureTest, testDeferredFutureExceptionSkipsStages")
+{
+    tclib::Promise<std::int32_t> promise;
+    auto secondCalled = false;
+    auto future = promise.getFuture()
+            .defer()
+            .then([](std::int32_t) -> std::int32_t { throw std::runtime_error("stage"); })
+            .then([&secondCalled](std::int32_t v) { secondCalled = true; return v; })
+            .toFuture();
+    promise.setValue(1);
+    REQUIRE_THROWS_AS(future.get(), std::runtime_error);
+    REQUIRE_FALSE(secondCalled);
+}
+
+TEST_CASE("FutureTest, testDeferredFutureGet")
+{
+    tclib::Promise<std::int32_t> promise;
+    auto deferred = promise.getFuture()
+            .defer()
+            .then([](std::int32_t v) { return v * 2; });
+    REQUIRE(deferred.valid());
+
+    auto setter = std::async(std::launch::async, [&promise]() { promise.setValue(21); });
+    REQUIRE(42 == std::move(deferred).get());
+    REQUIRE_FALSE(deferred.valid());
+    setter.get();
+}
+
+TEST_CASE("FutureTest, testDeferredFutureThrowsWithoutState")
+{
+    tclib::Future<std::int32_t> future;
+    REQUIRE_THROWS_AS(std::move(future).defer(), tclib::FutureError);
+}
+
+TEST_CASE("FutureTest, testThenValue")
+{
+    tclib::Promise<std::unique_ptr<std::int32_t>> promise;
+    auto future = promise.getFuture().thenValue([](std::unique_ptr<std::int32_t>&& value)
+    {
+        return *value + 1;
+    });
+    promise.setValue(std::make_unique<std::int32_t>(41));
+    REQUIRE(42 == future.get());
+}
+
+TEST_CASE("FutureTest, testThenValueSkippedOnException")
+{
+    tclib::Promise<std::int32_t> promise;
+    auto called = false;
+    auto future = promise.getFuture().thenValue([&called](std::int32_t&& value)
+    {
+        called = true;
+        return value;
+    });
+    promise.setException(std::make_exception_ptr(std::runtime_error("error")));
+    REQUIRE_THROWS_AS(future.get(), std::runtime_error);
+    REQUIRE_FALSE(called);
+}
+
+TEST_CASE("FutureTest, testThenValueVoid")
+{
+    tclib::Promise<void> promise;
+    auto future = promise.getFuture().thenValue([]() { return 42; });
+    promise.setValue();
+    REQUIRE(42 == future.get());
+}
+
+TEST_CASE("FutureTest, testThenError")
+{
+    tclib::Promise<std::int32_t> promise;
+    auto future = promise.getFuture()
+            .thenError<std::runtime_error>([](std::runtime_error& e) { return std::string(e.what()).size(); })
+            .thenValue([](std::size_t value) { return static_cast<std::int32_t>(value); });
+    promise.setException(std::make_exception_ptr(std::runtime_error("error")));
+    REQUIRE(5 == future.get());
+}
+
+TEST_CASE("FutureTest, testThenErrorPassesValueAndOtherExceptions")
+{
+    tclib::Promise<std::int32_t> valuePromise;
+    auto valueFuture = valuePromise.getFuture()
+            .thenError<std::runtime_error>([](std::runtime_error&) { return 0; });
+    valuePromise.setValue(42);
+    REQUIRE(42 == valueFuture.get());
+
+    tclib::Promise<std::int32_t> errorPromise;
+    auto errorFuture = errorPromise.getFuture()
+            .thenError<std::runtime_error>([](std::runtime_error&) { return 0; });
+    errorPromise.setException(std::make_exception_ptr(std::logic_error("error")));
+    REQUIRE_THROWS_AS(errorFuture.get(), std::logic_error);
+}
+
+TEST_CASE("FutureTest, testThenErrorVoid")
+{
+    tclib::Promise<void> promise;
+    auto handled = false;
+    auto future = promise.getFuture()
+            .thenError<tclib::FutureError>([&handled](tclib::FutureError&) { handled = true; });
+    promise.setException(std::make_exception_ptr(tclib::FutureError{tclib::FutureErrorCode::cancelled}));
+    REQUIRE_NOTHROW(future.get());
+    REQUIRE(handled);
+}
+
+TEST_CASE("FutureTest, testThenUnwrapsFuture")
+{
+    tclib::Promise<std::int32_t> promise;
+    tclib::Promise<std::string> inner;
+    auto innerFuture = inner.getFuture();
+
+    auto future = promise.getFuture().then([&innerFuture](tclib::Future<std::int32_t> f)
+    {
+        REQUIRE(42 == f.get());
+        return std::move(innerFuture);
+    });
+    static_assert(std::is_same<decltype(future), tclib::Future<std::string>>::value, "then should unwrap future");
+
+    promise.setValue(42);
+    inner.setValue("inner");
+    REQUIRE("inner" == future.get());
+}
+
+TEST_CASE("FutureTest, testThenUnwrapsFutureException")
+{
+    tclib::Promise<void> promise;
+    tclib::Promise<void> inner;
+    auto future = promise.getFuture().thenValue([&inner]() { return inner.getFuture(); });
+    promise.setValue();
+    inner.setException(std::make_exception_ptr(std::runtime_error("inner")));
+    REQUIRE_THROWS_AS(future.get(), std::runtime_error);
+}
+
+TEST_CASE("FutureTest, testThenUnwrapsInvalidFuture")
+{
+    tclib::Promise<std::int32_t> promise;
+    auto future = promise.getFuture().thenValue([](std::int32_t) { return tclib::Future<std::int32_t>(); });
+    promise.setValue(1);
+    REQUIRE_THROWS_AS(future.get(), tclib::FutureError);
+}
+
+TEST_CASE("FutureTest, testInterruptPropagatedToUnwrappedFuture")
+{
+    tclib::Promise<std::int32_t> promise;
+    tclib::Promise<std::int32_t> inner;
+    std::exception_ptr interrupt;
+    inner.setInterruptHandler([&interrupt](std::exception_ptr exc) { interrupt = exc; });
+
+    auto future = promise.getFuture().thenValue([&inner](std::int32_t) { return inner.getFuture(); });
+    promise.setValue(1);
+    future.cancel();
+    REQUIRE(nullptr != interrupt);
+    inner.setValue(2);
+    REQUIRE(2 == future.get());
+}
+
+TEST_CASE("FutureTest, testSharedStateLayout")
+{
+#ifdef TCLIB_ENABLE_CACHE_LINE_LAYOUT
+    STATIC_REQUIRE(alignof(tclib::SharedState<std::int32_t>) == tclib::s_cacheLineSize);
+    STATIC_REQUIRE(alignof(tclib::SharedState<void>) == tclib::s_cacheLineSize);
+    //flags, result and mutex groups
+    STATIC_REQUIRE(sizeof (tclib::SharedState<std::int32_t>) >= 3 * tclib::s_cacheLineSize);
+#else
+    STATIC_REQUIRE(alignof(tclib::SharedState<std::int32_t>) < tclib::s_cacheLineSize);
+#endif
+
+    tclib::Promise<std::int32_t> promise;
+    auto future = promise.getFuture();
+    promise.setValue(42);
+    REQUIRE(42 == future.get());
+}
+
+TEST_CASE("FutureTest, testFulfilAll")
+{
+    std::vector<std::pair<tclib::Promise<std::int32_t>, std::int32_t>> responses(4);
+    std::vector<tclib::Future<std::int32_t>> futures;
+    std::vector<std::int32_t> values;
+    for (std::size_t i = 0; i < responses.size(); ++i)
+    {
+        responses[i].second = static_cast<std::int32_t>(i);
+        futures.push_back(responses[i].first.getFuture().thenValue([&values](std::int32_t v)
+        {
+            values.push_back(v);
+            return v * 10;
+        }));
+    }
+
+    std::vector<tclib::UniqueFunction<void()>> jobs;
+    tclib::fulfilAll(responses, [&jobs](tclib::UniqueFunction<void()> job) { jobs.push_back(std::move(job)); });
+
+    //the states are set before any continuation runs, all continuations are in one job
+    REQUIRE(values.empty());
+    REQUIRE(1 == jobs.size());
+    jobs.front()();
+    REQUIRE(std::vector<std::int32_t>{0, 1, 2, 3} == values);
+    for (std::size_t i = 0; i < futures.size(); ++i)
+    {
+        REQUIRE(static_cast<std::int32_t>(i * 10) == futures[i].get());
+    }
+}
+
+TEST_CASE("FutureTest, testFulfilAllWithoutContinuations")
+{
+    std::vector<std::pair<tclib::Promise<std::int32_t>, std::int32_t>> responses(2);
+    auto first = responses[0].first.getFuture();
+    responses[0].second = 1;
+    responses[1].second = 2;
+
+    auto executorCalled = false;
+    tclib::fulfilAll(responses, [&executorCalled](tclib::UniqueFunction<void()>) { executorCalled = true; });
+    REQUIRE_FALSE(executorCalled);
+    REQUIRE(1 == first.get());
+}
+
+TEST_CASE("FutureTest, testFulfilAllInline")
+{
+    std::vector<std::pair<tclib::Promise<std::string>, std::string>> responses(2);
+    auto first = responses[0].first.getFuture().thenValue([](std::string s) { return s + "!"; });
+    auto second = responses[1].first.getFuture();
+    responses[0].second = "first";
+    responses[1].second = "second";
+
+    tclib::fulfilAll(responses);
+    REQUIRE("first!" == first.get());
+    REQUIRE("second" == second.get());
+}
+
+TEST_CASE("FutureTest, testFulfilAllVoid")
+{
+    std::vector<std::pair<tclib::Promise<void>, tclib::Unit>> responses(2);
+    auto called = false;
+    auto first = responses[0].first.getFuture().thenValue([&called]() { called = true; });
+    auto second = responses[1].first.getFuture();
+
+    tclib::fulfilAll(responses);
+    REQUIRE(called);
+    REQUIRE_NOTHROW(first.get());
+    REQUIRE_NOTHROW(second.get());
+}
+
+TEST_CASE("FutureTest, testFulfilAllWakesWaiter")
+{
+    std::vector<std::pair<tclib::Promise<std::int32_t>, std::int32_t>> responses(1);
+    responses[0].second = 42;
+    auto future = responses[0].first.getFuture();
+    auto waiter = std::async(std::launch::async, [&future]() { return future.get(); });
+
+    tclib::fulfilAll(responses, [](tclib::UniqueFunction<void()>) {});
+    REQUIRE(42 == waiter.get());
+}
+
+TEST_CASE("FutureTest, testFulfilAllAlreadySatisfied")
+{
+    std::vector<std::pair<tclib::Promise<std::int32_t>, std::int32_t>> responses(2);
+    auto first = responses[0].first.getFuture().thenValue([](std::int32_t v) { return v + 1; });
+    responses[0].second = 1;
+    responses[1].first.setValue(2);
+
+    std::vector<tclib::UniqueFunction<void()>> jobs;
+    REQUIRE_THROWS_AS(tclib::fulfilAll(responses, [&jobs](tclib::UniqueFunction<void()> job)
+    {
+        jobs.push_back(std::move(job));
+    }), tclib::FutureError);
+
+    //the continuation of the promise set before the failure is not lost
+    REQUIRE(1 == jobs.size());
+    jobs.front()();
+    REQUIRE(2 == first.get());
+}
+
+TEST_CASE("FutureTest, testSetValueToBatch")
+{
+    tclib::Promise<void> promise;
+    tclib::Promise<std::int32_t> failed;
+    auto calls = 0;
+    auto future = promise.getFuture().thenValue([&calls]() { ++calls; });
+    auto failedFuture = failed.getFuture().thenValue([&calls](std::int32_t v) { ++calls; return v; });
+
+    tclib::ContinuationBatch batch;
+    promise.setValue(batch);
+    failed.setException(std::make_exception_ptr(std::runtime_error("failed")), batch);
+    REQUIRE(2 == batch.size());
+    REQUIRE(0 == calls);
+
+    batch.run();
+    REQUIRE(batch.empty());
+    REQUIRE(1 == calls);
+    REQUIRE_NOTHROW(future.get());
+    REQUIRE_THROWS_AS(failedFuture.get(), std::runtime_error);
+}
+
+#if TCLIB_HAS_COROUTINES
+namespace
+{
+    /// Eagerly started coroutine that is not awaited by anyone.
+    struct DetachedCoroutine
+    {
+        struct promise_type
+        {
+            DetachedCoroutine get_return_object() noexcept { return {}; }
+            std::suspend_never initial_suspend() noexcept { return {}; }
+            std::suspend_never final_suspend() noexcept { return {}; }
+            void return_void() noexcept {}
+            void unhandled_exception() { std::terminate(); }
+        };
+    };
+
+    DetachedCoroutine awaitFuture(tclib::Future<std::int32_t> future, std::int32_t& result)
+    {
+        result = co_await std::move(future);
+    }
+
+    DetachedCoroutine awaitFutureVoid(tclib::Future<void> future, bool& done)
+    {
+        co_await std::move(future);
+        done = true;
+    }
+
+    DetachedCoroutine awaitSharedFuture(tclib::SharedFuture<std::int32_t> future, std::int32_t& result)
+    {
+        result = co_await future;
+    }
+
+    DetachedCoroutine awaitMoveOnlyFuture(tclib::Future<std::unique_ptr<std::int32_t>> future,
+                                          std::unique_ptr<std::int32_t>& result)
+    {
+        result = co_await std::move(future);
+    }
+
+    DetachedCoroutine awaitFutureException(tclib::Future<std::int32_t> future, bool& thrown)
+    {
+        try
+        {
+            co_await std::move(future);
+        }
+        catch (const std::logic_error&)
+        {
+            thrown = true;
+        }
+    }
+}
+
+TEST_CASE("FutureTest, testCoAwaitFuture")
+{
+    tclib::Promise<std::int32_t> promise;
+    std::int32_t result = 0;
+    awaitFuture(promise.getFuture(), result);
+
+    REQUIRE(0 == result);
+    promise.setValue(42);
+    REQUIRE(42 == result);
+}
+
+TEST_CASE("FutureTest, testCoAwaitReadyFuture")
+{
+    tclib::Promise<std::int32_t> promise;
+    promise.setValue(42);
+
+    std::int32_t result = 0;
+    awaitFuture(promise.getFuture(), result);
+    REQUIRE(42 == result);
+}
+
+TEST_CASE("FutureTest, testCoAwaitFutureVoid")
+{
+    tclib::Promise<void> promise;
+    bool done = false;
+    awaitFutureVoid(promise.getFuture(), done);
+
+    REQUIRE_FALSE(done);
+    promise.setValue();
+    REQUIRE(done);
+}
+
+TEST_CASE("FutureTest, testCoAwaitFutureOfMoveOnlyType")
+{
+    //the value is moved out of the state, not copied
+    tclib::Promise<std::unique_ptr<std::int32_t>> promise;
+    std::unique_ptr<std::int32_t> result;
+    awaitMoveOnlyFuture(promise.getFuture(), result);
+
+    REQUIRE(nullptr == result);
+    promise.setValue(std::make_unique<std::int32_t>(42));
+    REQUIRE(nullptr != result);
+    REQUIRE(42 == *result);
+
+    tclib::Promise<std::unique_ptr<std::int32_t>> ready;
+    ready.setValue(std::make_unique<std::int32_t>(7));
+    awaitMoveOnlyFuture(ready.getFuture(), result);
+    REQUIRE(7 == *result);
+}
+
+TEST_CASE("FutureTest, testCoAwaitSharedFuture")
+{
+    tclib::Promise<std::int32_t> promise;
+    tclib::SharedFuture<std::int32_t> sharedFuture(promise.getFuture());
+
+    std::int32_t result1 = 0;
+    std::int32_t result2 = 0;
+    awaitSharedFuture(sharedFuture, result1);
+    awaitSharedFuture(sharedFuture, result2);
+
+    promise.setValue(42);
+    REQUIRE(42 == result1);
+    REQUIRE(42 == result2);
+    REQUIRE(42 == sharedFuture.get());
+}
+
+TEST_CASE("FutureTest, testCoAwaitFutureException")
+{
+    tclib::Promise<std::int32_t> promise;
+    bool thrown = false;
+    awaitFutureException(promise.getFuture(), thrown);
+
+    promise.setException(std::make_exception_ptr(std::logic_error("Task failed!")));
+    REQUIRE(thrown);
+}
+
+TEST_CASE("FutureTest, testCoAwaitFulfilAll")
+{
+    std::vector<std::pair<tclib::Promise<std::int32_t>, std::int32_t>> responses(1);
+    responses[0].second = 42;
+    std::int32_t result = 0;
+    awaitFuture(responses[0].first.getFuture(), result);
+
+    std::vector<tclib::UniqueFunction<void()>> jobs;
+    tclib::fulfilAll(responses, [&jobs](tclib::UniqueFunction<void()> job) { jobs.push_back(std::move(job)); });
+    REQUIRE(0 == result);
+    REQUIRE(1 == jobs.size());
+    jobs.front()();
+    REQUIRE(42 == result);
+}
+
+TEST_CASE("FutureTest, testCoAwaitFutureFromAnotherThread")
+{
+    tclib::Promise<std::int32_t> promise;
+    std::int32_t result = 0;
+    awaitFuture(promise.getFuture(), result);
+
+    std::async(std::launch::async, [&promise]() { promise.setValue(42); }).wait();
+    REQUIRE(42 == result);
+}
+#endif
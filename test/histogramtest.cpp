@@ -0,0 +1,71 @@
+#include "catch2/catch.hpp"
+
+#include <future>
+#include <thread>
+#include "future.hpp"
+#include "histogram.hpp"
+#include "stats.hpp"
+
+TEST_CASE("HistogramTest, testBucketBounds")
+{
+    for (std::uint64_t value : std::initializer_list<std::uint64_t>{0, 1, 15, 16, 17, 1000, 123456789, UINT64_MAX})
+    {
+        const auto index = tclib::LatencyHistogram::bucketIndex(value);
+        REQUIRE(index < tclib::LatencyHistogram::s_bucketCount);
+        REQUIRE(tclib::LatencyHistogram::bucketLowerBound(index) <= value);
+        REQUIRE(value <= tclib::LatencyHistogram::bucketUpperBound(index));
+    }
+    for (std::size_t index = 1; index < tclib::LatencyHistogram::s_bucketCount; ++index)
+    {
+        REQUIRE(tclib::LatencyHistogram::bucketUpperBound(index - 1) + 1 ==
+                tclib::LatencyHistogram::bucketLowerBound(index));
+    }
+}
+
+TEST_CASE("HistogramTest, testPercentilesAndMerge")
+{
+    tclib::LatencyHistogram histogram;
+    REQUIRE(0 == histogram.valueAtPercentile(50));
+
+    for (std::uint64_t value = 1; value <= 1000; ++value)
+    {
+        histogram.record(value);
+    }
+    tclib::LatencyHistogram other;
+    other.record(1000000);
+    histogram.merge(other);
+
+    REQUIRE(1001 == histogram.count());
+
+    const auto p50 = histogram.valueAtPercentile(50);
+    REQUIRE(p50 >= 500);
+    REQUIRE(p50 <= 500 + 500 / tclib::LatencyHistogram::s_subBucketCount);
+
+    REQUIRE(histogram.valueAtPercentile(100) >= 1000000);
+}
+
+#ifdef TCLIB_ENABLE_LATENCY_STATS
+
+TEST_CASE("HistogramTest, testHandoffLatencies")
+{
+    const auto before = tclib::getLatencyStats();
+
+    tclib::Promise<std::int32_t> promise;
+    auto then = promise.getFuture().then([](tclib::Future<std::int32_t> future) { return future.get(); });
+
+    const auto statsBefore = tclib::getStats();
+    auto waitDone = std::async(std::launch::async, [&then]() { return then.get(); });
+    //the value is set once the waiter is parked, it holds the mutex of the state until then
+    while (0 == tclib::getStats().blockingWaitsStarted - statsBefore.blockingWaitsStarted)
+    {
+        std::this_thread::yield();
+    }
+    promise.setValue(42);
+    REQUIRE(42 == waitDone.get());
+
+    const auto after = tclib::getLatencyStats();
+    REQUIRE(1 == after.setToContinuationStart.count() - before.setToContinuationStart.count());
+    REQUIRE(1 == after.setToWake.count() - before.setToWake.count());
+}
+
+#endif
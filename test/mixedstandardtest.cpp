@@ -0,0 +1,111 @@
+#include "catch2/catch.hpp"
+
+#include <cstdint>
+#include <utility>
+#include "cpp17check.hpp"
+#include "task.hpp"
+
+#if TCLIB_HAS_COROUTINES
+
+//The shared states are created and set in the C++17 object file and awaited here,
+//so the definitions of the states must not depend on the language standard.
+namespace
+{
+    tclib::Task<std::int32_t> awaitFuture(tclib::Future<cpp17check::Value> future, bool& resumed)
+    {
+        auto value = co_await std::move(future);
+        resumed = true;
+        co_return value.m_value;
+    }
+
+    tclib::Task<std::int32_t> awaitSharedFuture(tclib::SharedFuture<cpp17check::Value> future, bool& resumed)
+    {
+        auto value = co_await future;
+        resumed = true;
+        co_return value.m_value;
+    }
+
+    tclib::Task<std::int32_t> sum(tclib::Stream<cpp17check::Value> stream, std::int32_t& consumed)
+    {
+        std::int32_t result = 0;
+        while (auto value = co_await stream.next())
+        {
+            result += value->m_value;
+            ++consumed;
+        }
+        co_return result;
+    }
+
+    tclib::Task<void> produce(tclib::StreamPromise<cpp17check::Value>& promise, std::int32_t count, std::int32_t& written)
+    {
+        for (std::int32_t i = 1; i <= count; ++i)
+        {
+            co_await promise.write(cpp17check::Value{i});
+            ++written;
+        }
+        promise.close();
+    }
+}
+
+TEST_CASE("MixedStandardTest, testAwaitStateOfCpp17Promise")
+{
+    auto promise = cpp17check::makePromise();
+    auto resumed = false;
+    auto future = awaitFuture(promise.getFuture(), resumed).toFuture();
+    REQUIRE_FALSE(resumed);
+
+    cpp17check::setValue(promise, 42);
+    REQUIRE(resumed);
+    REQUIRE(42 == future.get());
+}
+
+TEST_CASE("MixedStandardTest, testAwaitSharedStateOfCpp17Promise")
+{
+    auto promise = cpp17check::makePromise();
+    auto shared = promise.getFuture().share();
+    auto firstResumed = false;
+    auto secondResumed = false;
+    auto first = awaitSharedFuture(shared, firstResumed).toFuture();
+    auto second = awaitSharedFuture(shared, secondResumed).toFuture();
+
+    cpp17check::setValue(promise, 42);
+    REQUIRE(firstResumed);
+    REQUIRE(secondResumed);
+    REQUIRE(42 == first.get());
+    REQUIRE(42 == second.get());
+}
+
+TEST_CASE("MixedStandardTest, testConsumeStreamOfCpp17Producer")
+{
+    auto promise = cpp17check::makeStreamPromise(1);
+    std::int32_t consumed = 0;
+    auto future = sum(promise.getStream(), consumed).toFuture();
+    REQUIRE(0 == consumed);
+
+    cpp17check::push(promise, 1);
+    REQUIRE(1 == consumed);
+    cpp17check::push(promise, 2);
+    REQUIRE(2 == consumed);
+    cpp17check::close(promise);
+    REQUIRE(3 == future.get());
+}
+
+TEST_CASE("MixedStandardTest, testProduceStreamOfCpp17Consumer")
+{
+    auto promise = cpp17check::makeStreamPromise(1);
+    auto stream = promise.getStream();
+    std::int32_t written = 0;
+    auto future = produce(promise, 3, written).toFuture();
+    //the second value does not fit the buffer
+    REQUIRE(1 == written);
+
+    REQUIRE(1 == cpp17check::pop(stream));
+    REQUIRE(2 == written);
+    REQUIRE(2 == cpp17check::pop(stream));
+    REQUIRE(3 == cpp17check::pop(stream));
+    REQUIRE(-1 == cpp17check::pop(stream));
+    REQUIRE(3 == written);
+    future.get();
+}
+
+#endif
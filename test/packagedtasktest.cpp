@@ -0,0 +1,111 @@
+#include "catch2/catch.hpp"
+
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "packagedtask.hpp"
+
+TEST_CASE("PackagedTaskTest, testCall")
+{
+    tclib::PackagedTask<std::int32_t(std::int32_t, std::int32_t)> task([](std::int32_t a, std::int32_t b)
+    {
+        return a + b;
+    });
+    REQUIRE(task.valid());
+    auto future = task.getFuture();
+    task(40, 2);
+    REQUIRE(42 == future.get());
+    REQUIRE_THROWS_AS(task(1, 1), tclib::FutureError);
+}
+
+TEST_CASE("PackagedTaskTest, testVoidAndException")
+{
+    auto called = false;
+    tclib::PackagedTask<void()> task([&called]() { called = true; });
+    auto future = task.getFuture();
+    task();
+    REQUIRE_NOTHROW(future.get());
+    REQUIRE(called);
+
+    tclib::PackagedTask<std::int32_t()> throwing([]() -> std::int32_t { throw std::runtime_error("error"); });
+    auto throwingFuture = throwing.getFuture();
+    throwing();
+    REQUIRE_THROWS_AS(throwingFuture.get(), std::runtime_error);
+}
+
+TEST_CASE("PackagedTaskTest, testMoveOnlyCallableIsReleasedAfterCall")
+{
+    auto sp = std::make_shared<std::int32_t>(42);
+    tclib::PackagedTask<std::int32_t()> task([sp, up = std::make_unique<std::int32_t>(1)]() { return *sp + *up; });
+    auto future = task.getFuture();
+    REQUIRE(2 == sp.use_count());
+    task();
+    REQUIRE(1 == sp.use_count());
+    REQUIRE(43 == future.get());
+}
+
+TEST_CASE("PackagedTaskTest, testFutureResultIsNotUnwrapped")
+{
+    tclib::Promise<std::int32_t> promise;
+    tclib::PackagedTask<tclib::Future<std::int32_t>()> task([&promise]() { return promise.getFuture(); });
+    auto future = task.getFuture();
+    task();
+
+    auto inner = future.getTry().value();
+    REQUIRE(inner.valid());
+    promise.setValue(42);
+    REQUIRE(42 == inner.get());
+}
+
+TEST_CASE("PackagedTaskTest, testReadyFutureResultWithDroppedFuture")
+{
+    tclib::PackagedTask<tclib::Future<std::int32_t>()> task([]()
+    {
+        tclib::Promise<std::int32_t> promise;
+        promise.setValue(42);
+        return promise.getFuture();
+    });
+    task.getFuture();
+    REQUIRE_NOTHROW(task());
+}
+
+TEST_CASE("PackagedTaskTest, testBrokenPromise")
+{
+    tclib::Future<std::int32_t> future;
+    {
+        tclib::PackagedTask<std::int32_t()> task([]() { return 42; });
+        future = task.getFuture();
+    }
+    REQUIRE_THROWS_AS(future.get(), tclib::FutureError);
+
+    tclib::PackagedTask<std::int32_t()> empty;
+    REQUIRE_FALSE(empty.valid());
+    REQUIRE_THROWS_AS(empty.getFuture(), tclib::FutureError);
+    REQUIRE_THROWS_AS(empty(), tclib::FutureError);
+}
+
+TEST_CASE("PackagedTaskTest, testMoveIntoExecutorQueue")
+{
+    std::vector<tclib::UniqueFunction<void()>> queue;
+    std::vector<tclib::Future<std::int32_t>> futures;
+    for (std::int32_t i = 0; i < 10; ++i)
+    {
+        tclib::PackagedTask<std::int32_t()> task([i]() { return i * i; });
+        futures.push_back(task.getFuture());
+        queue.emplace_back(std::move(task));
+    }
+
+    std::thread worker([&queue]()
+    {
+        for (auto& task : queue)
+        {
+            task();
+        }
+    });
+    for (std::int32_t i = 0; i < 10; ++i)
+    {
+        REQUIRE(i * i == futures[static_cast<std::size_t>(i)].get());
+    }
+    worker.join();
+}
@@ -0,0 +1,117 @@
+#include "catch2/catch.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "promisearray.hpp"
+
+TEST_CASE("PromiseArrayTest, testSetAndGet")
+{
+    tclib::PromiseArray<std::int32_t> promises(8);
+    REQUIRE(8 == promises.size());
+    auto futures = promises.getFutures();
+    REQUIRE(8 == futures.size());
+
+    for (std::size_t i = 0; i < promises.size(); ++i)
+    {
+        promises[i].setValue(static_cast<std::int32_t>(i));
+    }
+    std::int32_t expected = 0;
+    for (auto& future : futures)
+    {
+        REQUIRE(expected++ == future.get());
+    }
+    REQUIRE_THROWS_AS(promises.getFutures(), tclib::FutureError);
+}
+
+TEST_CASE("PromiseArrayTest, testSlotsAreCacheLineAligned")
+{
+    using Slot = tclib::promisearray_details::Slot<std::int32_t>;
+    STATIC_REQUIRE(alignof(Slot) == tclib::s_cacheLineSize);
+    STATIC_REQUIRE(0 == sizeof (Slot) % tclib::s_cacheLineSize);
+
+    //the block is allocated with the alignment of the slots
+    std::unique_ptr<Slot[]> block(new Slot[3]);
+    REQUIRE(0 == reinterpret_cast<std::uintptr_t>(&block[0]) % tclib::s_cacheLineSize);
+}
+
+TEST_CASE("PromiseArrayTest, testBlockOutlivesArray")
+{
+    tclib::FutureArray<std::int32_t> futures;
+    std::vector<tclib::Promise<std::int32_t>> workers;
+    {
+        tclib::PromiseArray<std::int32_t> promises(2);
+        futures = promises.getFutures();
+        for (auto& promise : promises)
+        {
+            workers.push_back(std::move(promise));
+        }
+    }
+    workers[0].setValue(1);
+    workers.clear();
+    REQUIRE(1 == futures[0].get());
+    REQUIRE_THROWS_AS(futures[1].get(), tclib::FutureError);
+}
+
+TEST_CASE("PromiseArrayTest, testWhenAll")
+{
+    tclib::PromiseArray<std::int32_t> promises(64);
+    auto all = promises.getFutures().whenAll();
+
+    std::vector<std::thread> threads;
+    for (std::size_t i = 0; i < promises.size(); ++i)
+    {
+        threads.emplace_back([promise = std::move(promises[i]), i]() mutable
+        {
+            promise.setValue(static_cast<std::int32_t>(i));
+        });
+    }
+    const auto values = all.get();
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    REQUIRE(64 == values.size());
+    for (std::size_t i = 0; i < values.size(); ++i)
+    {
+        REQUIRE(static_cast<std::int32_t>(i) == values[i]);
+    }
+}
+
+TEST_CASE("PromiseArrayTest, testWhenAllException")
+{
+    tclib::PromiseArray<std::int32_t> promises(3);
+    auto all = promises.getFutures().whenAll();
+    promises[2].setException(std::make_exception_ptr(std::logic_error("second")));
+    promises[0].setValue(0);
+    promises[1].setException(std::make_exception_ptr(std::runtime_error("first")));
+    REQUIRE_THROWS_AS(all.get(), std::runtime_error);
+}
+
+TEST_CASE("PromiseArrayTest, testWhenAllVoidAndEmpty")
+{
+    tclib::PromiseArray<void> promises(2);
+    auto all = promises.getFutures().whenAll();
+    promises[0].setValue();
+    promises[1].setValue();
+    REQUIRE_NOTHROW(all.get());
+
+    tclib::PromiseArray<std::int32_t> empty(0);
+    REQUIRE(empty.getFutures().whenAll().get().empty());
+    tclib::PromiseArray<void> emptyVoid(0);
+    REQUIRE_NOTHROW(emptyVoid.getFutures().whenAll().get());
+}
+
+TEST_CASE("PromiseArrayTest, testWhenAllBrokenPromise")
+{
+    tclib::Future<std::vector<std::int32_t>> all;
+    {
+        tclib::PromiseArray<std::int32_t> promises(2);
+        all = promises.getFutures().whenAll();
+        promises[0].setValue(1);
+    }
+    REQUIRE_THROWS_AS(all.get(), tclib::FutureError);
+}
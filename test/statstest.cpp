@@ -0,0 +1,101 @@
+#include "catch2/catch.hpp"
+
+#include <future>
+#include <string>
+#include <thread>
+#include "future.hpp"
+#include "stats.hpp"
+
+#ifdef TCLIB_ENABLE_STATS
+
+TEST_CASE("StatsTest, testSharedStateCounters")
+{
+    const auto before = tclib::getStats();
+    {
+        tclib::Promise<std::int32_t> promise;
+        REQUIRE(1 == tclib::getStats().liveStates() - before.liveStates());
+
+        promise.setException(std::make_exception_ptr(std::logic_error("Task failed!")));
+    }
+    const auto after = tclib::getStats();
+
+    REQUIRE(1 == after.statesConstructed - before.statesConstructed);
+    REQUIRE(1 == after.statesDestructed - before.statesDestructed);
+    REQUIRE(1 == after.exceptionsPropagated - before.exceptionsPropagated);
+}
+
+TEST_CASE("StatsTest, testContinuationCounters")
+{
+    const auto before = tclib::getStats();
+
+    tclib::Promise<std::int32_t> promise;
+    promise.setValue(42);
+    auto then = promise.getFuture().then([](tclib::Future<std::int32_t> future) { return future.get(); });
+
+    tclib::Promise<std::int32_t> promise2;
+    auto then2 = promise2.getFuture().then([](tclib::Future<std::int32_t> future) { return future.get(); });
+    promise2.setValue(42);
+
+    const auto after = tclib::getStats();
+    REQUIRE(2 == after.continuationsAttached - before.continuationsAttached);
+    REQUIRE(1 == after.continuationsRunInline - before.continuationsRunInline);
+}
+
+TEST_CASE("StatsTest, testBlockingWaitCounters")
+{
+    tclib::Promise<std::int32_t> promise;
+    tclib::Future<std::int32_t> future = promise.getFuture();
+
+    const auto before = tclib::getStats();
+    auto pushDone = std::async(std::launch::async, [&promise, &before]()
+    {
+        //the value is set once the waiter is parked, it holds the mutex of the state until then
+        while (0 == tclib::getStats().blockingWaitsStarted - before.blockingWaitsStarted)
+        {
+            std::this_thread::yield();
+        }
+        promise.setValue(42);
+    });
+    future.wait();
+    pushDone.wait();
+    const auto after = tclib::getStats();
+
+    REQUIRE(1 == after.blockingWaitsStarted - before.blockingWaitsStarted);
+    REQUIRE(1 == after.blockingWaits - before.blockingWaits);
+    REQUIRE(0 == after.blockedWaiters());
+    REQUIRE(after.blockedNanoseconds > before.blockedNanoseconds);
+}
+
+TEST_CASE("StatsTest, testCountersOfExitedThreads")
+{
+    const auto before = tclib::getStats();
+    std::async(std::launch::async, []() { tclib::Promise<void> promise; }).wait();
+    const auto after = tclib::getStats();
+
+    REQUIRE(1 == after.statesConstructed - before.statesConstructed);
+}
+
+TEST_CASE("StatsTest, testUniqueFunctionHeapAllocations")
+{
+    const auto before = tclib::getStats();
+
+    auto data = std::string();
+    tclib::UniqueFunction<void()> small([]() {});
+    tclib::UniqueFunction<void()> big([data1 = data, data2 = data, data3 = data]() {});
+
+    const auto after = tclib::getStats();
+    REQUIRE(1 == after.uniqueFunctionHeapAllocations - before.uniqueFunctionHeapAllocations);
+}
+
+#else
+
+TEST_CASE("StatsTest, testStatsDisabled")
+{
+    tclib::Promise<std::int32_t> promise;
+    promise.setValue(42);
+
+    REQUIRE(0 == tclib::getStats().statesConstructed);
+    REQUIRE(0 == tclib::getStats().liveStates());
+}
+
+#endif
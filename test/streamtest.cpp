@@ -0,0 +1,170 @@
+#include "catch2/catch.hpp"
+
+#include <future>
+#include <thread>
+#include "stream.hpp"
+#include "task.hpp"
+
+TEST_CASE("StreamTest, testPushAndGet")
+{
+    tclib::StreamPromise<std::int32_t> promise(4);
+    tclib::Stream<std::int32_t> stream = promise.getStream();
+
+    auto pushDone = std::async(std::launch::async, [&promise]()
+    {
+        for (std::int32_t i = 0; i < 100; ++i)
+        {
+            promise.push(i);
+        }
+        promise.close();
+    });
+
+    std::int32_t sum = 0;
+    while (auto value = stream.get())
+    {
+        sum += *value;
+    }
+    pushDone.wait();
+
+    REQUIRE(99 * 100 / 2 == sum);
+    REQUIRE_FALSE(stream.get());
+}
+
+TEST_CASE("StreamTest, testProducerIsBlockedWhileBufferIsFull")
+{
+    constexpr std::size_t capacity = 2;
+    tclib::StreamPromise<std::int32_t> promise(capacity);
+    tclib::Stream<std::int32_t> stream = promise.getStream();
+
+    std::atomic<std::size_t> pushed{0};
+    auto pushDone = std::async(std::launch::async, [&promise, &pushed]()
+    {
+        for (std::int32_t i = 0; i < 10; ++i)
+        {
+            promise.push(i);
+            ++pushed;
+        }
+        promise.close();
+    });
+
+    //the first pushes do not block, wait until the buffer is full
+    while (capacity != pushed)
+    {
+        std::this_thread::yield();
+    }
+
+    //before every get the producer is ahead of the consumer by at most the capacity
+    std::size_t count = 0;
+    for (;;)
+    {
+        REQUIRE(pushed <= count + capacity);
+        if (!stream.get())
+        {
+            break;
+        }
+        ++count;
+    }
+    pushDone.wait();
+    REQUIRE(10 == count);
+}
+
+TEST_CASE("StreamTest, testStreamException")
+{
+    tclib::StreamPromise<std::int32_t> promise;
+    tclib::Stream<std::int32_t> stream = promise.getStream();
+
+    promise.push(42);
+    promise.setException(std::make_exception_ptr(std::logic_error("Task failed!")));
+
+    REQUIRE(42 == stream.get().value());
+    REQUIRE_THROWS_AS(stream.get(), std::logic_error);
+    REQUIRE_THROWS_AS(promise.push(42), tclib::FutureError);
+}
+
+TEST_CASE("StreamTest, testBrokenPromise")
+{
+    tclib::Stream<std::int32_t> stream;
+    {
+        tclib::StreamPromise<std::int32_t> promise;
+        stream = promise.getStream();
+    }
+    REQUIRE_THROWS_AS(stream.get(), tclib::FutureError);
+}
+
+TEST_CASE("StreamTest, testMoveAssignedPromiseEndsStream")
+{
+    tclib::StreamPromise<std::int32_t> promise;
+    tclib::Stream<std::int32_t> stream = promise.getStream();
+
+    promise = tclib::StreamPromise<std::int32_t>();
+
+    REQUIRE_THROWS_AS(stream.get(), tclib::FutureError);
+    REQUIRE_NOTHROW(promise.getStream());
+}
+
+TEST_CASE("StreamTest, testAbandonedStreamUnblocksProducer")
+{
+    tclib::StreamPromise<std::int32_t> promise(1);
+    auto stream = std::make_unique<tclib::Stream<std::int32_t>>(promise.getStream());
+
+    REQUIRE(promise.push(1));
+
+    auto pushDone = std::async(std::launch::async, [&promise]()
+    {
+        return promise.push(2);
+    });
+
+    stream.reset();
+    REQUIRE_FALSE(pushDone.get());
+}
+
+#if TCLIB_HAS_COROUTINES
+namespace
+{
+    tclib::Task<void> produce(tclib::StreamPromise<std::int32_t> promise, std::int32_t count)
+    {
+        for (std::int32_t i = 0; i < count; ++i)
+        {
+            co_await promise.write(i);
+        }
+        promise.close();
+    }
+
+    tclib::Task<std::int32_t> consume(tclib::Stream<std::int32_t> stream)
+    {
+        std::int32_t sum = 0;
+        while (auto value = co_await stream.next())
+        {
+            sum += *value;
+        }
+        co_return sum;
+    }
+}
+
+TEST_CASE("StreamTest, testCoroutineProducerAndConsumer")
+{
+    tclib::StreamPromise<std::int32_t> promise(2);
+    auto stream = promise.getStream();
+
+    auto produced = produce(std::move(promise), 1000).toFuture();
+    REQUIRE(999 * 1000 / 2 == tclib::syncWait(consume(std::move(stream))));
+    produced.get();
+}
+
+TEST_CASE("StreamTest, testCoroutineConsumerAndThreadProducer")
+{
+    tclib::StreamPromise<std::int32_t> promise(2);
+    auto consumed = consume(promise.getStream()).toFuture();
+
+    std::async(std::launch::async, [&promise]()
+    {
+        for (std::int32_t i = 0; i < 1000; ++i)
+        {
+            promise.push(i);
+        }
+        promise.close();
+    }).wait();
+
+    REQUIRE(999 * 1000 / 2 == consumed.get());
+}
+#endif
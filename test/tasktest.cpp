@@ -0,0 +1,119 @@
+#include "catch2/catch.hpp"
+
+#include <future>
+#include "task.hpp"
+
+#if TCLIB_HAS_COROUTINES
+
+namespace
+{
+    tclib::Task<std::int32_t> value(std::int32_t x)
+    {
+        co_return x;
+    }
+
+    tclib::Task<std::int32_t> twice(std::int32_t x)
+    {
+        auto result = co_await value(x);
+        co_return result * 2;
+    }
+
+    tclib::Task<void> fail()
+    {
+        throw std::logic_error("Task failed!");
+        co_return;
+    }
+
+    tclib::Task<void> setFlag(bool& started)
+    {
+        started = true;
+        co_return;
+    }
+
+    tclib::Task<std::int32_t> awaitFuture(tclib::Future<std::int32_t> future)
+    {
+        co_return co_await std::move(future);
+    }
+
+    tclib::Task<std::int32_t> awaitTask(tclib::Future<std::int32_t> future)
+    {
+        auto result = co_await awaitFuture(std::move(future));
+        co_return result * 2;
+    }
+
+    tclib::Task<std::int64_t> sum(std::int32_t count)
+    {
+        std::int64_t result = 0;
+        for (std::int32_t i = 0; i < count; ++i)
+        {
+            result += co_await value(i);
+        }
+        co_return result;
+    }
+
+    tclib::Task<std::int32_t> depth(std::int32_t n)
+    {
+        if (0 == n)
+        {
+            co_return 0;
+        }
+        co_return 1 + co_await depth(n - 1);
+    }
+}
+
+TEST_CASE("TaskTest, testSyncWait")
+{
+    REQUIRE(42 * 2 == tclib::syncWait(twice(42)));
+}
+
+TEST_CASE("TaskTest, testTaskIsLazy")
+{
+    bool started = false;
+    auto task = setFlag(started);
+
+    REQUIRE(task.valid());
+    REQUIRE_FALSE(started);
+
+    tclib::syncWait(std::move(task));
+    REQUIRE(started);
+    REQUIRE_FALSE(task.valid());
+}
+
+TEST_CASE("TaskTest, testTaskException")
+{
+    REQUIRE_THROWS_AS(tclib::syncWait(fail()), std::logic_error);
+}
+
+TEST_CASE("TaskTest, testTaskToFuture")
+{
+    tclib::Promise<std::int32_t> promise;
+    tclib::Future<std::int32_t> future = awaitFuture(promise.getFuture()).toFuture();
+
+    std::async(std::launch::async, [&promise]() { promise.setValue(42); }).wait();
+
+    REQUIRE(42 == future.get());
+}
+
+TEST_CASE("TaskTest, testAwaitAsynchronouslyCompletedTask")
+{
+    tclib::Promise<std::int32_t> promise;
+    tclib::Future<std::int32_t> future = awaitTask(promise.getFuture()).toFuture();
+
+    std::async(std::launch::async, [&promise]() { promise.setValue(42); }).wait();
+
+    REQUIRE(42 * 2 == future.get());
+}
+
+TEST_CASE("TaskTest, testLongCoAwaitChain")
+{
+    constexpr std::int32_t count = 1000000;
+    REQUIRE(std::int64_t{count} * (count - 1) / 2 == tclib::syncWait(sum(count)));
+}
+
+TEST_CASE("TaskTest, testDeepCoAwaitRecursion")
+{
+    constexpr std::int32_t count = 1000000;
+    REQUIRE(count == tclib::syncWait(depth(count)));
+}
+
+#endif
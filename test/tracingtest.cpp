@@ -0,0 +1,118 @@
+#include "catch2/catch.hpp"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "future.hpp"
+#include "tracing.hpp"
+
+#ifdef TCLIB_ENABLE_TRACING
+
+namespace
+{
+    struct TraceEvent
+    {
+        std::string name;
+        tclib::TraceContext context;
+    };
+
+    class RecordingTraceHooks : public tclib::TraceHooks
+    {
+    public:
+        RecordingTraceHooks() { tclib::setTraceHooks(this); }
+        ~RecordingTraceHooks() override { tclib::setTraceHooks(nullptr); }
+
+        void onStateCreated(const tclib::TraceContext& context) override { m_events.push_back({"created", context}); }
+        void onSetValue(const tclib::TraceContext& context) override { m_events.push_back({"value", context}); }
+        void onSetException(const tclib::TraceContext& context, const std::exception_ptr&) override
+        {
+            m_events.push_back({"exception", context});
+        }
+        void onContinuationStart(const tclib::TraceContext& context) override { m_events.push_back({"start", context}); }
+        void onContinuationEnd(const tclib::TraceContext& context) override { m_events.push_back({"end", context}); }
+
+        std::vector<TraceEvent> m_events;
+    };
+}
+
+TEST_CASE("TracingTest, testThenChainIsTraced")
+{
+    RecordingTraceHooks hooks;
+
+    tclib::Promise<std::int32_t> promise;
+    auto then = promise.getFuture()
+            .then([](tclib::Future<std::int32_t> future) { return future.get() * 2; })
+            .then([](tclib::Future<std::int32_t> future) -> std::int32_t
+            {
+                future.get();
+                throw std::logic_error("Task failed!");
+            });
+    promise.setValue(42);
+    REQUIRE_THROWS_AS(then.get(), std::logic_error);
+
+    auto& events = hooks.m_events;
+    REQUIRE(3 <= events.size());
+    REQUIRE("created" == events[0].name);
+    REQUIRE("created" == events[1].name);
+    REQUIRE("created" == events[2].name);
+
+    const auto root = events[0].context;
+    const auto first = events[1].context;
+    const auto second = events[2].context;
+    REQUIRE(0 == root.parentId);
+    REQUIRE(root.id == root.chainId);
+    REQUIRE(root.id == first.parentId);
+    REQUIRE(first.id == second.parentId);
+    REQUIRE(root.id == second.chainId);
+
+    std::vector<std::string> names;
+    for (std::size_t i = 3; i < events.size(); ++i)
+    {
+        names.push_back(events[i].name + std::to_string(events[i].context.id));
+    }
+    const auto id = [](const tclib::TraceContext& context) { return std::to_string(context.id); };
+    REQUIRE(std::vector<std::string>{"value" + id(root),
+                                     "start" + id(root),
+                                     "value" + id(first),
+                                     "start" + id(first),
+                                     "exception" + id(second),
+                                     "end" + id(first),
+                                     "end" + id(root)} == names);
+}
+
+TEST_CASE("TracingTest, testStateCreatedByContinuationIsChild")
+{
+    RecordingTraceHooks hooks;
+
+    tclib::Promise<std::int32_t> promise;
+    tclib::Promise<std::int32_t> inner;
+    auto then = promise.getFuture().then([&inner](tclib::Future<std::int32_t> future)
+    {
+        inner = tclib::Promise<std::int32_t>();
+        return future.get();
+    });
+    promise.setValue(42);
+
+    const auto root = hooks.m_events[0].context;
+    const auto& created = hooks.m_events;
+    auto it = std::find_if(created.rbegin(), created.rend(), [](const TraceEvent& e) { return "created" == e.name; });
+    REQUIRE(it != created.rend());
+    REQUIRE(root.id == it->context.parentId);
+    REQUIRE(root.id == it->context.chainId);
+}
+
+#else
+
+TEST_CASE("TracingTest, testTracingDisabled")
+{
+    struct Hooks : tclib::TraceHooks {};
+    Hooks hooks;
+    tclib::TraceHooks& base = hooks;
+    base.onSetValue(tclib::TraceContext{});
+
+    tclib::Promise<void> promise;
+    promise.setValue();
+    REQUIRE_NOTHROW(promise.getFuture().get());
+}
+
+#endif
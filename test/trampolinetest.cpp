@@ -0,0 +1,139 @@
+#include "catch2/catch.hpp"
+
+#include <stdexcept>
+#include <vector>
+#include "future.hpp"
+#include "trampoline.hpp"
+
+TEST_CASE("TrampolineTest, testNestedContinuationsAreQueuedInOrder")
+{
+    std::vector<std::size_t> order;
+    std::size_t maxDepth = 0;
+    std::size_t depth = 0;
+
+    //every continuation schedules the next one from inside, like a chain of ready then()
+    tclib::UniqueFunction<void(std::size_t)> schedule;
+    schedule = [&](std::size_t i)
+    {
+        if (i == 1000)
+        {
+            return;
+        }
+        tclib::trampoline_details::run([&, i]()
+        {
+            ++depth;
+            maxDepth = std::max(maxDepth, depth);
+            order.push_back(i);
+            schedule(i + 1);
+            --depth;
+        });
+    };
+    schedule(0);
+
+    REQUIRE(order.size() == 1000);
+    for (std::size_t i = 0; i < order.size(); ++i)
+    {
+        REQUIRE(order[i] == i);
+    }
+    REQUIRE(maxDepth == tclib::trampoline_details::s_maxInlineDepth);
+}
+
+TEST_CASE("TrampolineTest, testQueueIsDrainedWhenContinuationThrows")
+{
+    std::size_t ran = 0;
+    auto nest = [&](auto& self, std::size_t level) -> void
+    {
+        tclib::trampoline_details::run([&, level]()
+        {
+            ++ran;
+            if (level < 2 * tclib::trampoline_details::s_maxInlineDepth)
+            {
+                self(self, level + 1);
+            }
+            if (0 == level || tclib::trampoline_details::s_maxInlineDepth + 1 == level)
+            {
+                throw std::runtime_error("failed");
+            }
+        });
+    };
+
+    //the outermost continuation throws after its nested ones are queued, one queued continuation throws too
+    REQUIRE_THROWS_AS(nest(nest, 0), std::runtime_error);
+    REQUIRE(2 * tclib::trampoline_details::s_maxInlineDepth + 1 == ran);
+
+    //the next outermost continuation does not run the leftovers of the failed one
+    ran = 0;
+    tclib::trampoline_details::run([&ran]() { ++ran; });
+    REQUIRE(1 == ran);
+}
+
+TEST_CASE("TrampolineTest, testBlockingGetOnQueuedContinuation")
+{
+    //the last continuation of the chain is queued, the first one waits for it
+    tclib::Promise<std::int32_t> promise;
+    auto future = promise.getFuture();
+    for (std::size_t i = 0; i < 2 * tclib::trampoline_details::s_maxInlineDepth; ++i)
+    {
+        future = future.thenValue([](std::int32_t value) { return value + 1; });
+    }
+
+    std::int32_t result = 0;
+    tclib::trampoline_details::run([&]()
+    {
+        promise.setValue(0);
+        result = future.get();
+    });
+    REQUIRE(2 * static_cast<std::int32_t>(tclib::trampoline_details::s_maxInlineDepth) == result);
+}
+
+TEST_CASE("TrampolineTest, testLongThenChain")
+{
+    constexpr std::int32_t chainLength = 100000;
+
+    tclib::Promise<std::int32_t> promise;
+    auto future = promise.getFuture();
+    for (std::int32_t i = 0; i < chainLength; ++i)
+    {
+        future = future.then([](tclib::Future<std::int32_t> f)
+        {
+            return f.get() + 1;
+        });
+    }
+    promise.setValue(0);
+    REQUIRE(future.get() == chainLength);
+}
+
+TEST_CASE("TrampolineTest, testLongReadyThenChain")
+{
+    constexpr std::int32_t chainLength = 100000;
+
+    tclib::Promise<void> promise;
+    promise.setValue();
+    auto future = promise.getFuture().then([](tclib::Future<void>) { return 0; });
+    for (std::int32_t i = 1; i < chainLength; ++i)
+    {
+        future = future.then([](tclib::Future<std::int32_t> f)
+        {
+            return f.get() + 1;
+        });
+    }
+    REQUIRE(future.get() == chainLength - 1);
+}
+
+TEST_CASE("TrampolineTest, testLongBrokenChain")
+{
+    constexpr std::int32_t chainLength = 100000;
+
+    std::optional<tclib::Promise<std::int32_t>> promise;
+    promise.emplace();
+    auto future = promise->getFuture();
+    for (std::int32_t i = 0; i < chainLength; ++i)
+    {
+        future = future.then([](tclib::Future<std::int32_t> f)
+        {
+            return f.get() + 1;
+        });
+    }
+    promise.reset();
+    REQUIRE_THROWS_AS(future.get(), tclib::FutureError);
+}
@@ -0,0 +1,115 @@
+#include "catch2/catch.hpp"
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include "future.hpp"
+#include "try.hpp"
+
+TEST_CASE("TryTest, testValue")
+{
+    tclib::Try<std::string> result(std::string("value"));
+    REQUIRE(result.hasValue());
+    REQUIRE_FALSE(result.hasException());
+    REQUIRE(nullptr == result.exception());
+    REQUIRE("value" == result.value());
+    REQUIRE("value" == std::move(result).value());
+}
+
+TEST_CASE("TryTest, testException")
+{
+    tclib::Try<std::int32_t> result(std::make_exception_ptr(std::runtime_error("error")));
+    REQUIRE_FALSE(result.hasValue());
+    REQUIRE(result.hasException());
+    REQUIRE(nullptr != result.exception());
+    REQUIRE_THROWS_AS(result.value(), std::runtime_error);
+}
+
+TEST_CASE("TryTest, testVoid")
+{
+    tclib::Try<void> value;
+    REQUIRE(value.hasValue());
+    REQUIRE_NOTHROW(value.value());
+
+    tclib::Try<void> exception(std::make_exception_ptr(std::runtime_error("error")));
+    REQUIRE(exception.hasException());
+    REQUIRE_THROWS_AS(exception.value(), std::runtime_error);
+}
+
+TEST_CASE("TryTest, testFutureGetTry")
+{
+    tclib::Promise<std::unique_ptr<std::int32_t>> promise;
+    auto future = promise.getFuture();
+    promise.setValue(std::make_unique<std::int32_t>(42));
+    auto result = future.getTry();
+    REQUIRE_FALSE(future.valid());
+    REQUIRE(result.hasValue());
+    REQUIRE(42 == *result.value());
+
+    tclib::Promise<void> voidPromise;
+    auto voidFuture = voidPromise.getFuture();
+    voidPromise.setException(std::make_exception_ptr(std::runtime_error("error")));
+    REQUIRE(voidFuture.getTry().hasException());
+}
+
+TEST_CASE("TryTest, testSharedFutureGetTry")
+{
+    tclib::Promise<std::int32_t> promise;
+    auto future = promise.getFuture().share();
+    auto copy = future;
+    promise.setException(std::make_exception_ptr(std::runtime_error("error")));
+    REQUIRE(future.getTry().hasException());
+    REQUIRE(copy.getTry().hasException());
+}
+
+TEST_CASE("TryTest, testPromiseSetTry")
+{
+    tclib::Promise<std::int32_t> promise;
+    auto future = promise.getFuture();
+    promise.setTry(tclib::Try<std::int32_t>(42));
+    REQUIRE(42 == future.get());
+
+    tclib::Promise<void> voidPromise;
+    auto voidFuture = voidPromise.getFuture();
+    voidPromise.setTry(tclib::Try<void>(std::make_exception_ptr(std::runtime_error("error"))));
+    REQUIRE_THROWS_AS(voidFuture.get(), std::runtime_error);
+}
+
+TEST_CASE("TryTest, testThenTryPassesErrorsWithoutRethrow")
+{
+    tclib::Promise<std::int32_t> promise;
+    auto future = promise.getFuture();
+    std::int32_t errors = 0;
+    for (std::int32_t i = 0; i < 10; ++i)
+    {
+        future = future.thenTry([&errors](tclib::Try<std::int32_t>&& result)
+        {
+            if (result.hasException())
+            {
+                ++errors;
+                return 0;
+            }
+            return result.value() + 1;
+        }).thenTry([](tclib::Try<std::int32_t>&& result)
+        {
+            return std::move(result).value();
+        });
+    }
+    promise.setException(std::make_exception_ptr(std::runtime_error("error")));
+    REQUIRE(9 == future.get());
+    REQUIRE(1 == errors);
+}
+
+TEST_CASE("TryTest, testThenTryForwardsResultToPromise")
+{
+    tclib::Promise<std::int32_t> promise;
+    tclib::Promise<std::int32_t> forwarded;
+    auto forwardedFuture = forwarded.getFuture();
+    auto future = promise.getFuture().thenTry([&forwarded](tclib::Try<std::int32_t>&& result)
+    {
+        forwarded.setTry(std::move(result));
+    });
+    promise.setException(std::make_exception_ptr(std::runtime_error("error")));
+    future.get();
+    REQUIRE_THROWS_AS(forwardedFuture.get(), std::runtime_error);
+}
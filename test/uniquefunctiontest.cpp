@@ -1,6 +1,7 @@
 #include "catch2/catch.hpp"
 
 #include <memory>
+#include <string>
 
 #include "uniquefunction.hpp"
 
@@ -119,3 +120,63 @@ TEST_CASE("UniqueFunctionTest, testFunctionSize")
     REQUIRE(sizeof(f) <= 8 * sizeof (void*));
     REQUIRE(sizeof(tclib::UniqueFunction<void()>) <= 8 * sizeof (void*));
 }
+
+TEST_CASE("UniqueFunctionTest, testMultiSignatureCallOperator")
+{
+    struct ResultHandler
+    {
+        void operator()(int&& value) { *m_value = value; }
+        void operator()(std::exception_ptr exc) { *m_exception = exc; }
+
+        int* m_value;
+        std::exception_ptr* m_exception;
+    };
+
+    int value = 0;
+    std::exception_ptr exception;
+    tclib::UniqueFunction<void(int&&), void(std::exception_ptr)> f(ResultHandler{&value, &exception});
+    REQUIRE(f);
+
+    f(42);
+    REQUIRE(42 == value);
+    REQUIRE_FALSE(exception);
+
+    f(std::make_exception_ptr(std::logic_error("Task failed!")));
+    REQUIRE(exception);
+
+    tclib::UniqueFunction<void(int&&), void(std::exception_ptr)> fEmpty;
+    REQUIRE_FALSE(fEmpty);
+    REQUIRE(nullptr == fEmpty);
+    REQUIRE_THROWS_AS(fEmpty(42), std::bad_function_call);
+}
+
+TEST_CASE("UniqueFunctionTest, testMultiSignatureMoveAndSwap")
+{
+    auto sp = std::make_shared<int>(42);
+    auto data = std::string();
+
+    auto small = [sp](auto&&...){ return *sp; };
+    auto big = [sp, data1 = data, data2 = data, data3 = data](auto&&...){ return *sp + 1; };
+
+    using FunctionType = tclib::UniqueFunction<int(int), int(const std::string&)>;
+    FunctionType f1(std::move(small));
+    FunctionType f2(std::move(big));
+    REQUIRE(3 == sp.use_count());
+
+    swap(f1, f2);
+    REQUIRE(43 == f1(0));
+    REQUIRE(42 == f2(std::string()));
+    REQUIRE(3 == sp.use_count());
+
+    FunctionType f3(std::move(f1));
+    REQUIRE_FALSE(f1);
+    REQUIRE(43 == f3(std::string()));
+
+    f3 = std::move(f2);
+    REQUIRE_FALSE(f2);
+    REQUIRE(42 == f3(0));
+    REQUIRE(2 == sp.use_count());
+
+    f3 = nullptr;
+    REQUIRE(1 == sp.use_count());
+}